@@ -0,0 +1,143 @@
+#ifndef GL_STUB_H
+#define GL_STUB_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+// Fake GL driver for benchmarking CPU-side code without a context.
+// gladLoadGLLoader(GLStub::getProcAddress) points every GLAD entry point at
+// a stub. Uniform calls are counted and glGetUniformLocation hashes the name
+// the way a driver's lookup would have to touch it, so the numbers measure
+// our side of the call (string building, lookups) and not a real driver.
+// Programs report the uniforms of basic.vert/basic.frag as active.
+namespace GLStub {
+
+inline long long uniformCalls = 0;
+inline long long locationLookups = 0;
+inline float sink = 0.0f;
+
+inline const GLubyte* APIENTRY getString(GLenum name)
+{
+    if (name == GL_VERSION) return (const GLubyte*)"3.3.0 bench stub";
+    return (const GLubyte*)"";
+}
+// GLAD gives up when a context reports no extensions at all
+inline const GLubyte* APIENTRY getStringi(GLenum, GLuint) { return (const GLubyte*)"GL_bench_stub"; }
+inline void APIENTRY getIntegerv(GLenum name, GLint* data) { *data = name == GL_NUM_EXTENSIONS ? 1 : 0; }
+
+inline GLint APIENTRY getUniformLocation(GLuint, const GLchar* name)
+{
+    locationLookups++;
+    unsigned int hash = 2166136261u; // FNV-1a
+    for (const char* c = name; *c; c++)
+        hash = (hash ^ (unsigned char)*c) * 16777619u;
+    return (GLint)(hash & 0xFF);
+}
+
+inline void APIENTRY uniform1i(GLint loc, GLint v) { uniformCalls++; sink += (float)(loc + v); }
+inline void APIENTRY uniform1f(GLint loc, GLfloat v) { uniformCalls++; sink += loc + v; }
+inline void APIENTRY uniform2f(GLint loc, GLfloat x, GLfloat) { uniformCalls++; sink += loc + x; }
+inline void APIENTRY uniform3f(GLint loc, GLfloat x, GLfloat, GLfloat) { uniformCalls++; sink += loc + x; }
+inline void APIENTRY uniform4f(GLint loc, GLfloat x, GLfloat, GLfloat, GLfloat) { uniformCalls++; sink += loc + x; }
+inline void APIENTRY uniformfv(GLint loc, GLsizei, const GLfloat* v) { uniformCalls++; sink += loc + v[0]; }
+inline void APIENTRY uniformMatrixfv(GLint loc, GLsizei, GLboolean, const GLfloat* v) { uniformCalls++; sink += loc + v[0]; }
+
+// what a linked basic.vert/basic.frag reports, so Shader's reflection
+// builds the same table it would against a driver. The rest of their
+// uniforms live in blocks (UniformBlocks.h)
+inline const char* const activeUniforms[] = { "model", "uInstanceOffset" };
+inline constexpr GLint activeUniformCount = sizeof(activeUniforms) / sizeof(activeUniforms[0]);
+
+inline long long bufferUploads = 0;
+inline void APIENTRY bufferSubData(GLenum, GLintptr, GLsizeiptr size, const void* data)
+{
+    bufferUploads++;
+    sink += ((const unsigned char*)data)[size - 1];
+}
+// draw submissions and VAO binds, what the arena is meant to cut down
+inline long long drawCalls = 0;
+inline long long vertexArrayBinds = 0;
+inline void APIENTRY drawElements(GLenum, GLsizei, GLenum, const void*) { drawCalls++; }
+inline void APIENTRY drawElementsBaseVertex(GLenum, GLsizei, GLenum, const void*, GLint) { drawCalls++; }
+inline void APIENTRY multiDrawElementsBaseVertex(GLenum, const GLsizei*, GLenum, const void* const*, GLsizei,
+                                                 const GLint*) { drawCalls++; }
+inline void APIENTRY bindVertexArray(GLuint array) { vertexArrayBinds += array != 0; }
+inline GLuint APIENTRY getUniformBlockIndex(GLuint, const GLchar*) { return 0; }
+
+// compile/link always succeed
+inline void APIENTRY getObjectiv(GLuint, GLenum name, GLint* params)
+{
+    if (name == GL_ACTIVE_UNIFORMS) *params = activeUniformCount;
+    else if (name == GL_ACTIVE_UNIFORM_MAX_LENGTH) *params = 64;
+    else *params = GL_TRUE;
+}
+inline void APIENTRY getActiveUniform(GLuint, GLuint index, GLsizei bufSize, GLsizei* length,
+                                      GLint* size, GLenum* type, GLchar* name)
+{
+    const char* uniform = (GLint)index < activeUniformCount ? activeUniforms[index] : "";
+    GLsizei n = std::min((GLsizei)std::strlen(uniform), bufSize - 1);
+    std::memcpy(name, uniform, n);
+    name[n] = '\0';
+    if (length) *length = n;
+    *size = 1;
+    *type = GL_FLOAT;
+}
+
+inline GLuint nextName = 1;
+inline GLuint APIENTRY createObject(GLenum) { return nextName++; }
+inline GLuint APIENTRY createProgram() { return nextName++; }
+inline void APIENTRY genNames(GLsizei n, GLuint* names)
+{
+    for (GLsizei i = 0; i < n; i++)
+        names[i] = nextName++;
+}
+
+// everything else does nothing, the return value is never looked at
+inline void APIENTRY noop() {}
+
+// matches the GLADloadproc signature
+inline void* getProcAddress(const char* name)
+{
+    struct Entry { const char* name; void* fn; };
+    static const Entry entries[] = {
+        { "glGetString", (void*)&getString },
+        { "glGetStringi", (void*)&getStringi },
+        { "glGetIntegerv", (void*)&getIntegerv },
+        { "glGetUniformLocation", (void*)&getUniformLocation },
+        { "glUniform1i", (void*)&uniform1i },
+        { "glUniform1f", (void*)&uniform1f },
+        { "glUniform2f", (void*)&uniform2f },
+        { "glUniform3f", (void*)&uniform3f },
+        { "glUniform4f", (void*)&uniform4f },
+        { "glUniform2fv", (void*)&uniformfv },
+        { "glUniform3fv", (void*)&uniformfv },
+        { "glUniform4fv", (void*)&uniformfv },
+        { "glUniformMatrix2fv", (void*)&uniformMatrixfv },
+        { "glUniformMatrix3fv", (void*)&uniformMatrixfv },
+        { "glUniformMatrix4fv", (void*)&uniformMatrixfv },
+        { "glGetShaderiv", (void*)&getObjectiv },
+        { "glGetProgramiv", (void*)&getObjectiv },
+        { "glGetActiveUniform", (void*)&getActiveUniform },
+        { "glGetUniformBlockIndex", (void*)&getUniformBlockIndex },
+        { "glBufferSubData", (void*)&bufferSubData },
+        { "glDrawElements", (void*)&drawElements },
+        { "glDrawElementsBaseVertex", (void*)&drawElementsBaseVertex },
+        { "glMultiDrawElementsBaseVertex", (void*)&multiDrawElementsBaseVertex },
+        { "glBindVertexArray", (void*)&bindVertexArray },
+        { "glCreateShader", (void*)&createObject },
+        { "glCreateProgram", (void*)&createProgram },
+        { "glGenBuffers", (void*)&genNames },
+        { "glGenVertexArrays", (void*)&genNames },
+        { "glGenTextures", (void*)&genNames },
+    };
+    for (const Entry& entry : entries)
+        if (std::strcmp(entry.name, name) == 0)
+            return entry.fn;
+    return (void*)&noop;
+}
+
+} // namespace GLStub
+#endif
@@ -0,0 +1,172 @@
+#ifndef MICRO_BENCH_H
+#define MICRO_BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Keeps the compiler from optimizing away a result that is never read
+template <typename T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// Summary of one benchmark, all times are per iteration in nanoseconds
+struct MicroBenchResult {
+    std::string name;
+    long long iterations = 0; // per sample, picked during calibration
+    int samples = 0;
+    double mean = 0.0;
+    double stddev = 0.0;
+    double min = 0.0;
+    double median = 0.0;
+    double max = 0.0;
+
+    // coefficient of variation in percent, high values mean a noisy run
+    double cv() const { return mean > 0.0 ? 100.0 * stddev / mean : 0.0; }
+};
+
+// Tiny microbenchmark harness.
+// Each benchmark is calibrated first: the iteration count doubles until one
+// sample takes at least minSampleMs, so timer resolution doesn't matter.
+// Then warmupSamples samples are run and thrown away (caches, allocator,
+// CPU clocks), and `samples` samples are timed. Reporting per-sample spread
+// (stddev, min, median) instead of one total is what makes two runs
+// comparable; compare medians and treat a cv above ~5% as noise.
+class MicroBench {
+public:
+    double minSampleMs = 20.0;
+    int warmupSamples = 3;
+    int samples = 20;
+    std::string filter;   // substring, empty runs everything
+    std::vector<MicroBenchResult> results;
+
+    // fn runs one iteration
+    template <typename Fn>
+    void run(const std::string& name, Fn&& fn)
+    {
+        if (!filter.empty() && name.find(filter) == std::string::npos)
+            return;
+
+        long long iterations = 1;
+        while (true) {
+            double ms = timeSample(fn, iterations) / 1.0e6;
+            if (ms >= minSampleMs || iterations >= (1LL << 40))
+                break;
+            // jump close to the target once the sample is long enough to trust
+            double scale = ms > minSampleMs / 100.0 ? 1.2 * minSampleMs / ms : 10.0;
+            iterations = std::max(iterations + 1, (long long)(iterations * std::min(scale, 10.0)));
+        }
+
+        for (int i = 0; i < warmupSamples; i++)
+            timeSample(fn, iterations);
+
+        std::vector<double> perIteration;
+        for (int i = 0; i < samples; i++)
+            perIteration.push_back(timeSample(fn, iterations) / (double)iterations);
+
+        MicroBenchResult result = summarize(name, iterations, perIteration);
+        print(result);
+        results.push_back(result);
+    }
+
+    static void printHeader()
+    {
+        std::cout << std::left << std::setw(36) << "benchmark" << std::right
+                  << std::setw(14) << "median" << std::setw(14) << "mean"
+                  << std::setw(14) << "min" << std::setw(9) << "cv" << std::setw(14) << "iters" << "\n";
+    }
+
+    bool writeJSON(const std::string& path) const
+    {
+        std::ofstream out(path);
+        if (!out) {
+            std::cout << "ERROR::BENCH::COULD_NOT_OPEN " << path << std::endl;
+            return false;
+        }
+        out << "{\n  \"unit\": \"ns\",\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const MicroBenchResult& r = results[i];
+            out << "    { \"name\": \"" << r.name << "\", "
+                << "\"iterations\": " << r.iterations << ", "
+                << "\"samples\": " << r.samples << ", "
+                << "\"median\": " << r.median << ", "
+                << "\"mean\": " << r.mean << ", "
+                << "\"stddev\": " << r.stddev << ", "
+                << "\"min\": " << r.min << ", "
+                << "\"max\": " << r.max << ", "
+                << "\"cv_pct\": " << r.cv() << " }"
+                << (i + 1 == results.size() ? "\n" : ",\n");
+        }
+        out << "  ]\n}\n";
+        return (bool)out;
+    }
+
+private:
+    template <typename Fn>
+    static double timeSample(Fn& fn, long long iterations)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (long long i = 0; i < iterations; i++)
+            fn();
+        auto end = std::chrono::steady_clock::now();
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    }
+
+    static MicroBenchResult summarize(const std::string& name, long long iterations,
+                                      std::vector<double> values)
+    {
+        MicroBenchResult r;
+        r.name = name;
+        r.iterations = iterations;
+        r.samples = (int)values.size();
+        if (values.empty())
+            return r;
+        std::sort(values.begin(), values.end());
+        double sum = 0.0;
+        for (double v : values) sum += v;
+        r.mean = sum / values.size();
+        double sq = 0.0;
+        for (double v : values) sq += (v - r.mean) * (v - r.mean);
+        r.stddev = values.size() > 1 ? std::sqrt(sq / (values.size() - 1)) : 0.0;
+        r.min = values.front();
+        r.max = values.back();
+        size_t mid = values.size() / 2;
+        r.median = values.size() % 2 ? values[mid] : 0.5 * (values[mid - 1] + values[mid]);
+        return r;
+    }
+
+    static std::string formatNs(double ns)
+    {
+        std::ostringstream s;
+        s << std::fixed << std::setprecision(ns < 10.0 ? 2 : 1);
+        if (ns < 1.0e3)      s << ns << " ns";
+        else if (ns < 1.0e6) s << ns / 1.0e3 << " us";
+        else                 s << ns / 1.0e6 << " ms";
+        return s.str();
+    }
+
+    static void print(const MicroBenchResult& r)
+    {
+        std::ostringstream cv;
+        cv << std::fixed << std::setprecision(1) << r.cv() << "%";
+        std::cout << std::left << std::setw(36) << r.name << std::right
+                  << std::setw(14) << formatNs(r.median) << std::setw(14) << formatNs(r.mean)
+                  << std::setw(14) << formatNs(r.min) << std::setw(9) << cv.str()
+                  << std::setw(14) << r.iterations << std::endl;
+    }
+};
+#endif
@@ -0,0 +1,374 @@
+#include <glad/glad.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Shader.h"
+#include "Mesh.h"
+#include "Model.h"
+#include "Geometry.h"
+#include "MeshOptimizer.h"
+#include "Meshlets.h"
+#include "GeometryArena.h"
+#include "FurPhysics.h"
+#include "UniformBlocks.h"
+
+#include "GLStub.h"
+#include "MicroBench.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/* ----------
+CPU microbenchmarks, no window or GL context needed (GL calls go to GLStub):
+- cmake -DCMAKE_BUILD_TYPE=Release .. && cmake --build . --target bench && ./bench
+  --filter TEXT    only run benchmarks whose name contains TEXT
+  --samples N      timed samples per benchmark (default 20)
+  --warmup N       samples thrown away before timing (default 3)
+  --min-time MS    minimum length of one sample (default 20)
+  --json FILE      also write the results as JSON
+  --texture FILE   image to time stbi_load on, can be repeated
+                   (default ../Demo/Fur_Render.png)
+Run from build/ like OpenGlShell so the shader paths resolve.
+---------- */
+
+// synthetic assimp mesh with everything processMesh reads; like assimp
+// itself the mesh owns its arrays
+static aiMesh* makeAssimpMesh(int stacks, int slices)
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    generateSphere(1.0f, stacks, slices, vertices, indices);
+
+    aiMesh* mesh = new aiMesh;
+    mesh->mNumVertices = (unsigned int)vertices.size();
+    mesh->mVertices = new aiVector3D[vertices.size()];
+    mesh->mNormals = new aiVector3D[vertices.size()];
+    mesh->mTangents = new aiVector3D[vertices.size()];
+    mesh->mBitangents = new aiVector3D[vertices.size()];
+    mesh->mTextureCoords[0] = new aiVector3D[vertices.size()];
+    for (size_t i = 0; i < vertices.size(); i++) {
+        const Vertex& v = vertices[i];
+        mesh->mVertices[i] = aiVector3D(v.Position.x, v.Position.y, v.Position.z);
+        mesh->mNormals[i] = aiVector3D(v.Normal.x, v.Normal.y, v.Normal.z);
+        mesh->mTangents[i] = aiVector3D(1.0f, 0.0f, 0.0f);
+        mesh->mBitangents[i] = aiVector3D(0.0f, 0.0f, 1.0f);
+        mesh->mTextureCoords[0][i] = aiVector3D(v.TexCoords.x, v.TexCoords.y, 0.0f);
+    }
+    mesh->mNumFaces = (unsigned int)(indices.size() / 3);
+    mesh->mFaces = new aiFace[mesh->mNumFaces];
+    for (unsigned int f = 0; f < mesh->mNumFaces; f++) {
+        mesh->mFaces[f].mNumIndices = 3;
+        mesh->mFaces[f].mIndices = new unsigned int[3];
+        for (int k = 0; k < 3; k++)
+            mesh->mFaces[f].mIndices[k] = indices[f * 3 + k];
+    }
+    return mesh;
+}
+
+// what main() uploads every frame: the three shared blocks and the per-draw
+// uniforms of cubeShader
+struct FrameUniforms {
+    UniformBuffer<FrameBlock> frame;
+    UniformBuffer<LightBlock> lights;
+    UniformBuffer<FurBlock> fur;
+    UniformHandle model, instanceOffset;
+};
+
+static void setFrameUniforms(Shader& shader, FrameUniforms& u, const glm::vec3& cameraPos,
+                             const glm::vec3& cameraFront, const glm::mat4& view, const glm::mat4& projection)
+{
+    glm::vec3 ambientColor(0.02f), diffuseColor(0.4f);
+    shader.use();
+    LightBlock& lights = u.lights.data;
+    lights.dirLight.direction = glm::vec3(-0.2f, -1.0f, -0.3f);
+    lights.dirLight.ambient = ambientColor;
+    lights.dirLight.diffuse = diffuseColor;
+    lights.dirLight.specular = glm::vec3(0.5f);
+    lights.pointLights[0].position = glm::vec3(0.7f, 0.2f, 2.0f);
+    lights.pointLights[0].constant = 1.0f;
+    lights.pointLights[0].linear = 0.09f;
+    lights.pointLights[0].quadratic = 0.032f;
+    lights.pointLights[0].ambient = ambientColor;
+    lights.pointLights[0].diffuse = diffuseColor;
+    lights.pointLights[0].specular = glm::vec3(1.0f);
+    lights.spotLight.position = cameraPos;
+    lights.spotLight.direction = cameraFront;
+    lights.spotLight.ambient = glm::vec3(0.0f);
+    lights.spotLight.diffuse = glm::vec3(1.0f);
+    lights.spotLight.specular = glm::vec3(1.0f);
+    lights.spotLight.constant = 1.0f;
+    lights.spotLight.linear = 0.09f;
+    lights.spotLight.quadratic = 0.032f;
+    lights.spotLight.cutOff = glm::cos(glm::radians(12.5f));
+    lights.spotLight.outerCutOff = glm::cos(glm::radians(17.5f));
+    lights.spotLight.flashLightEnable = 0;
+
+    u.frame.data.view = view;
+    u.frame.data.projection = projection;
+    u.frame.data.viewPos = cameraPos;
+    u.frame.data.currFrame = 1.0f;
+
+    FurBlock& fur = u.fur.data;
+    fur.baseColor = glm::vec3(0.8f, 0.7f, 0.6f);
+    fur.numLayers = 80;
+    fur.furLength = 0.15f;
+    fur.windDirection = glm::vec3(0.3f, 0.0f, 0.1f);
+    fur.gravity = glm::vec3(0.0f, -1.0f, 0.0f);
+    fur.strandThickness = 0.9f;
+    fur.gridFrequency = 1500.0f;
+
+    u.frame.upload();
+    u.lights.upload();
+    u.fur.upload();
+    shader.setMat4(u.model, glm::mat4(1.0f));
+    shader.setInt(u.instanceOffset, 0);
+    shader.setInt(u.instanceOffset, 1);
+}
+
+int main(int argc, char** argv)
+{
+    MicroBench bench;
+    std::string jsonPath;
+    std::vector<std::string> textures;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--filter" && hasValue) bench.filter = argv[++i];
+        else if (arg == "--samples" && hasValue) bench.samples = std::max(2, std::atoi(argv[++i]));
+        else if (arg == "--warmup" && hasValue) bench.warmupSamples = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--min-time" && hasValue) bench.minSampleMs = std::max(0.1, std::atof(argv[++i]));
+        else if (arg == "--json" && hasValue) jsonPath = argv[++i];
+        else if (arg == "--texture" && hasValue) textures.push_back(argv[++i]);
+        else {
+            std::cout << "ERROR::BENCH::UNKNOWN_ARGUMENT " << arg << std::endl;
+            return -1;
+        }
+    }
+    if (textures.empty())
+        textures.push_back("../Demo/Fur_Render.png");
+
+    if (!gladLoadGLLoader((GLADloadproc)GLStub::getProcAddress)) {
+        std::cout << "ERROR::BENCH::GL_STUB_FAILED" << std::endl;
+        return -1;
+    }
+
+#ifndef NDEBUG
+    std::cout << "WARNING::BENCH::NOT_A_RELEASE_BUILD numbers are not representative, "
+                 "configure with -DCMAKE_BUILD_TYPE=Release" << std::endl;
+#endif
+    MicroBench::printHeader();
+
+    // ---- sphere generation, as done once at startup in main() ----
+    {
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        bench.run("sphere/32x32", [&] {
+            generateSphere(1.0f, 32, 32, vertices, indices);
+            doNotOptimize(vertices.data());
+        });
+        bench.run("sphere/256x256", [&] {
+            generateSphere(1.0f, 256, 256, vertices, indices);
+            doNotOptimize(vertices.data());
+        });
+    }
+
+    // ---- vertex stream packing, done once per mesh before upload ----
+    {
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        generateSphere(1.0f, 256, 256, vertices, indices);
+        std::vector<unsigned char> packed;
+        bench.run("streams/pack shell 66k verts", [&] {
+            packVertexStream(STREAM_SHELL, vertices, packed);
+            doNotOptimize(packed.data());
+        });
+        VertexQuantization quantization = VertexQuantization::fromBounds(vertices);
+        bench.run("streams/pack shell quantized 66k verts", [&] {
+            packVertexStream(STREAM_SHELL_QUANTIZED, vertices, packed, &quantization);
+            doNotOptimize(packed.data());
+        });
+    }
+
+    // ---- index reordering, done once per mesh before upload ----
+    {
+        std::vector<Vertex> source, vertices;
+        std::vector<unsigned int> sourceIndices, indices;
+        generateSphere(1.0f, 128, 128, source, sourceIndices);
+        bench.run("mesh/optimize sphere 32k tris", [&] {
+            vertices = source;
+            indices = sourceIndices;
+            MeshOptimizer::optimize(vertices, indices);
+            doNotOptimize(indices.data());
+        });
+    }
+
+    // ---- meshlet culling, every frame before the shells are drawn ----
+    {
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        generateSphere(1.0f, 128, 128, vertices, indices);
+        Meshlets meshlets;
+        bench.run("meshlets/build sphere 32k tris", [&] {
+            meshlets.build(vertices, indices, GL_UNSIGNED_SHORT);
+            doNotOptimize(meshlets.meshlets.data());
+        });
+        // two views in turn, so every cull also compacts and uploads
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f);
+        glm::mat4 views[2] = { glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
+                               glm::lookAt(glm::vec3(3.0f, 0.0f, 0.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)) };
+        int frame = 0;
+        bench.run("meshlets/cull and compact 32k tris", [&] {
+            meshlets.cull(glm::mat4(1.0f), views[frame++ & 1], projection, 0.3f);
+            doNotOptimize(&meshlets.trianglesDrawn);
+        });
+        meshlets.destroy();
+    }
+
+    // ---- Model::processMesh vertex/index conversion ----
+    {
+        aiMesh* small = makeAssimpMesh(32, 32);
+        aiMesh* large = makeAssimpMesh(256, 256);
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        bench.run("model/extractGeometry 2k tris", [&] {
+            vertices.clear();
+            indices.clear();
+            Model::extractGeometry(small, vertices, indices);
+            doNotOptimize(vertices.data());
+        });
+        bench.run("model/extractGeometry 131k tris", [&] {
+            vertices.clear();
+            indices.clear();
+            Model::extractGeometry(large, vertices, indices);
+            doNotOptimize(vertices.data());
+        });
+        // what Model::processMesh does with the extracted data, textures aside
+        bench.run("model/extract + Mesh 131k tris", [&] {
+            std::vector<Vertex> meshVertices;
+            std::vector<unsigned int> meshIndices;
+            Model::extractGeometry(large, meshVertices, meshIndices);
+            Mesh mesh(std::move(meshVertices), std::move(meshIndices), {});
+            doNotOptimize(&mesh);
+        });
+        delete small;
+        delete large;
+    }
+
+    // ---- Model::Draw submission, 64 small meshes over 4 materials ----
+    {
+        Shader shader("basic.vert", "basic.frag");
+        const int meshCount = 64;
+        GeometryArena arena;
+        std::vector<Mesh> separate, pooled;
+        separate.reserve(meshCount);
+        pooled.reserve(meshCount);
+        for (int i = 0; i < meshCount; i++) {
+            std::vector<Vertex> vertices;
+            std::vector<unsigned int> indices;
+            generateSphere(1.0f, 8, 8, vertices, indices);
+            std::vector<Texture> textures = { { (unsigned int)(1 + i / 16), "texture_diffuse", "" } };
+            separate.emplace_back(vertices, indices, textures);
+            pooled.emplace_back(std::move(vertices), std::move(indices), std::move(textures), arena);
+        }
+        std::vector<const GeometryArena::Allocation*> batch;
+        // calls one draw of the model makes, for the names
+        auto submissions = [](const std::function<void()>& draw) {
+            long long draws = GLStub::drawCalls, binds = GLStub::vertexArrayBinds;
+            draw();
+            return std::to_string(GLStub::drawCalls - draws) + " draws, " +
+                   std::to_string(GLStub::vertexArrayBinds - binds) + " VAOs";
+        };
+        VertexDecodeUniforms decode;
+        decode.resolve(shader);
+        auto drawSeparate = [&] {
+            for (Mesh& mesh : separate)
+                mesh.Draw(shader, decode);
+        };
+        auto drawPooled = [&] { Model::drawFromArena(shader, decode, arena, pooled, 1, batch); };
+        bench.run("draw/per mesh (" + submissions(drawSeparate) + ")", drawSeparate);
+        bench.run("draw/arena (" + submissions(drawPooled) + ")", drawPooled);
+    }
+
+    // ---- Shader::set* uniform path ----
+    {
+        Shader shader("basic.vert", "basic.frag");
+        glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+        bench.run("shader/setInt", [&] {
+            shader.setInt("uInstanceOffset", 1);
+        });
+        bench.run("shader/setMat4", [&] {
+            shader.setMat4("model", projection);
+        });
+        UniformHandle instanceOffset = shader.uniform("uInstanceOffset");
+        UniformHandle model = shader.uniform("model");
+        bench.run("shader/setInt handle", [&] {
+            shader.setInt(instanceOffset, 1);
+        });
+        bench.run("shader/setMat4 handle", [&] {
+            shader.setMat4(model, projection);
+        });
+
+        FrameUniforms frame;
+        frame.frame.create(FRAME_BLOCK_BINDING);
+        frame.lights.create(LIGHT_BLOCK_BINDING);
+        frame.fur.create(FUR_BLOCK_BINDING);
+        bindUniformBlocks(shader);
+        frame.model = model;
+        frame.instanceOffset = instanceOffset;
+        // the first frame uploads everything, after that unchanged values are elided
+        setFrameUniforms(shader, frame, glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, -1.0f), view, projection);
+        long long callsBefore = GLStub::uniformCalls + GLStub::bufferUploads;
+        long long elidedBefore = UniformUploadStats::elided;
+        setFrameUniforms(shader, frame, glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, -1.0f), view, projection);
+        long long callsPerFrame = GLStub::uniformCalls + GLStub::bufferUploads - callsBefore;
+        long long elidedPerFrame = UniformUploadStats::elided - elidedBefore;
+        bench.run("shader/frame uniforms (" + std::to_string(callsPerFrame) + " calls, " +
+                  std::to_string(elidedPerFrame) + " elided)", [&] {
+            setFrameUniforms(shader, frame, glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, -1.0f), view, projection);
+        });
+        doNotOptimize(GLStub::sink);
+    }
+
+    // ---- updateFurPhysics ----
+    {
+        FurPhysics physics;
+        float t = 0.0f;
+        bench.run("furPhysics/update", [&] {
+            t += 1.0f / 60.0f;
+            physics.update(glm::vec3(3.0f * sin(t), 0.0f, 3.0f * cos(t)), 1.0f / 60.0f);
+            doNotOptimize(physics.windDirection);
+        });
+    }
+
+    // ---- stbi_load, what TextureFromFile spends its time on ----
+    for (const std::string& path : textures) {
+        int width = 0, height = 0, channels = 0;
+        if (!stbi_info(path.c_str(), &width, &height, &channels)) {
+            std::cout << "ERROR::BENCH::TEXTURE_NOT_LOADED " << path << std::endl;
+            continue;
+        }
+        std::string name = "stbi_load/" + std::filesystem::path(path).filename().string() + " " +
+                           std::to_string(width) + "x" + std::to_string(height);
+        bench.run(name, [&] {
+            int w, h, n;
+            unsigned char* data = stbi_load(path.c_str(), &w, &h, &n, 0);
+            doNotOptimize(data);
+            stbi_image_free(data);
+        });
+    }
+
+    if (!jsonPath.empty() && bench.writeJSON(jsonPath))
+        std::cout << "Bench: results written to " << jsonPath << std::endl;
+    return 0;
+}
@@ -11,37 +11,58 @@ flat out int vInstanceID;
 
 out float vLayer;
 
+#include "include/blocks.glsl"
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform int uInstanceOffset; // first layer of this draw, layers can be split over draws
 
-uniform int uNumLayers;
-uniform float uFurLength;
+// quantized meshes (see VertexLayout.h) store positions and UVs as unorm16
+// within these bounds and the normal octahedral in aNormal.xy
+uniform bool uQuantized;
+uniform vec3 uPositionMin;
+uniform vec3 uPositionExtent;
+uniform vec2 uUVMin;
+uniform vec2 uUVExtent;
 
-uniform vec3 uGravity;
-uniform vec3 uWindDirection;
+vec3 octDecode(vec2 f)
+{
+    vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+    float t = max(-n.z, 0.0);
+    n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+    return normalize(n);
+}
 
 void main()
 {
+    int instanceID = gl_InstanceID + uInstanceOffset;
     float layer = (uNumLayers > 1) // ensures that if layer less than 1 will be 0
-        ? float(gl_InstanceID) / float(uNumLayers - 1)
+        ? float(instanceID) / float(uNumLayers - 1)
         : 0.0;
     vLayer = layer;
 
-    vec3 shellPos = aPos + aNormal * (layer * uFurLength); // base shell position
+    vec3 position = aPos;
+    vec3 normal = aNormal;
+    vec2 texCoord = aTexCoord;
+    if (uQuantized) {
+        position = uPositionMin + aPos * uPositionExtent;
+        normal = octDecode(aNormal.xy);
+        texCoord = uUVMin + aTexCoord * uUVExtent;
+    }
+
+    vec3 shellPos = position + normal * (layer * uFurLength); // base shell position
 
     float layerSquared = layer * layer; // used to bend like hair rather than uniform
     shellPos += uGravity * layerSquared * 0.1; // applies minimal gravity
     // Applies wind direction based on movement
     shellPos += uWindDirection * layerSquared * 0.15;
 
-    vInstanceID = gl_InstanceID;
+    vInstanceID = instanceID;
 
     mat3 normalMatrix = transpose(inverse(mat3(model)));
-    vNormal = normalMatrix * aNormal;   
+    vNormal = normalMatrix * normal;   
 
-    vLocalPos = aPos;
-    vTexCoord = aTexCoord;
+    vLocalPos = position;
+    vTexCoord = texCoord;
 
     vec4 worldPos = model * vec4(shellPos, 1.0); // uses shell position instead
     FragPos = worldPos.xyz;
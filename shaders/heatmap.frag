@@ -0,0 +1,28 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 vUV;
+
+// red = fragments rasterized, green = fragments kept (see overdraw.frag)
+uniform sampler2D uCounts;
+uniform int uChannel;        // 0 rasterized, 1 wasted (discarded), 2 survived
+uniform float uMaxOverdraw;  // count that maps to the hottest color
+
+// black -> blue -> green -> yellow -> red
+vec3 heatRamp(float t)
+{
+    t = clamp(t, 0.0, 1.0);
+    vec3 c = mix(vec3(0.0), vec3(0.0, 0.0, 1.0), smoothstep(0.0, 0.25, t));
+    c = mix(c, vec3(0.0, 1.0, 0.0), smoothstep(0.25, 0.5, t));
+    c = mix(c, vec3(1.0, 1.0, 0.0), smoothstep(0.5, 0.75, t));
+    return mix(c, vec3(1.0, 0.0, 0.0), smoothstep(0.75, 1.0, t));
+}
+
+void main()
+{
+    vec2 counts = texture(uCounts, vUV).rg;
+    float value = counts.r;
+    if(uChannel == 1) value = counts.r - counts.g;
+    if(uChannel == 2) value = counts.g;
+    FragColor = vec4(heatRamp(value / uMaxOverdraw), 1.0);
+}
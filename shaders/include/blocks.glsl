@@ -0,0 +1,16 @@
+// std140 blocks shared by all programs, mirrored in src/UniformBlocks.h
+layout (std140) uniform FrameBlock {
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+    float currFrame;
+};
+layout (std140) uniform FurBlock {
+    vec3 baseColor;
+    int uNumLayers;
+    vec3 uGravity;
+    float uFurLength;
+    vec3 uWindDirection;
+    float uStrandThickness;
+    float uGridFrequency;
+};
@@ -0,0 +1,5 @@
+// hash like function for shell texturing, one value per grid cell
+float rand(vec2 p)
+{
+    return fract(sin(dot(p, vec2(37.7, 17.7))) * 43758.5453);
+}
@@ -0,0 +1,44 @@
+#version 330 core
+out vec4 FragColor;
+
+// Overdraw diagnostics, drawn with basic.vert. Runs the same strand test as
+// basic.frag but never discards. With additive blending into a float target
+// red ends up as the number of fragments rasterized per pixel and green as
+// the number basic.frag would have kept.
+
+in vec3 vNormal;
+in vec3 FragPos;
+in vec2 vTexCoord;
+flat in int vInstanceID;
+
+in float vLayer;
+
+#include "include/blocks.glsl"
+#include "include/strands.glsl"
+
+// mirrors the discards in basic.frag
+bool survives()
+{
+    if(vInstanceID == 0) return true; // base layer is always drawn
+
+    float layer = vLayer;
+    vec2 uv = vTexCoord * uGridFrequency;
+    float height = rand(floor(uv));
+    if(height < layer) return false;
+
+    float earlyLayerBoost = (layer < 0.3) ? 1.0 : 0.7;
+    float distFromCenter = length(fract(uv) * 2.0 - 1.0);
+    float radius = uStrandThickness * (height - layer) * (1.0 + earlyLayerBoost * 0.3);
+    if(distFromCenter > radius) return false;
+
+    vec3 norm = normalize(vNormal);
+    vec3 viewDir = normalize(viewPos - FragPos);
+    float edgeFade = smoothstep(0.0, 0.4, abs(dot(norm, viewDir)));
+    float layerFade = smoothstep(0.85, 1.0, layer);
+    return edgeFade * (1.0 - layerFade) >= 0.01;
+}
+
+void main()
+{
+    FragColor = vec4(1.0, survives() ? 1.0 : 0.0, 0.0, 0.0);
+}
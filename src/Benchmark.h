@@ -0,0 +1,235 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// One point on the benchmark timeline, everything between keys is
+// linearly interpolated
+struct BenchmarkKey {
+    float time;
+    glm::vec3 cameraPos;
+    glm::vec3 cameraTarget;
+    int numLayers;
+    float gridFreq;
+    float strandThickness;
+    float furLength;
+};
+
+// Scripted camera path and fur parameter schedule.
+// Script files hold one key per line, '#' starts a comment:
+//   time  camX camY camZ  targetX targetY targetZ  numLayers gridFreq strandThickness furLength
+class BenchmarkScript {
+public:
+    std::string name = "default";
+    std::vector<BenchmarkKey> keys;
+
+    // built-in orbit around the sphere that ramps the layer count and density
+    static BenchmarkScript makeDefault()
+    {
+        BenchmarkScript script;
+        const int steps = 8;
+        for (int i = 0; i <= steps; i++) {
+            float t = (float)i / steps;
+            float angle = t * glm::two_pi<float>();
+            BenchmarkKey key;
+            key.time = t * 10.0f;
+            key.cameraPos = glm::vec3(3.0f * sin(angle), 0.5f * sin(angle * 2.0f), 3.0f * cos(angle));
+            key.cameraTarget = glm::vec3(0.0f);
+            key.numLayers = 32 + (int)(96 * t);
+            key.gridFreq = glm::mix(800.0f, 2000.0f, t);
+            key.strandThickness = glm::mix(0.6f, 0.9f, t);
+            key.furLength = glm::mix(0.08f, 0.25f, t);
+            script.keys.push_back(key);
+        }
+        return script;
+    }
+
+    bool loadFromFile(const std::string& path)
+    {
+        std::ifstream file(path);
+        if (!file) {
+            std::cout << "ERROR::BENCHMARK::FILE_NOT_SUCCESFULLY_READ " << path << std::endl;
+            return false;
+        }
+        keys.clear();
+        name = path;
+
+        std::string line;
+        int lineNr = 0;
+        while (std::getline(file, line)) {
+            lineNr++;
+            line = line.substr(0, line.find('#'));
+            if (line.find_first_not_of(" \t\r") == std::string::npos)
+                continue;
+
+            std::istringstream in(line);
+            BenchmarkKey key;
+            in >> key.time
+               >> key.cameraPos.x >> key.cameraPos.y >> key.cameraPos.z
+               >> key.cameraTarget.x >> key.cameraTarget.y >> key.cameraTarget.z
+               >> key.numLayers >> key.gridFreq >> key.strandThickness >> key.furLength;
+            if (!in) {
+                std::cout << "ERROR::BENCHMARK::BAD_KEY at " << path << ":" << lineNr << std::endl;
+                return false;
+            }
+            if (!keys.empty() && key.time <= keys.back().time) {
+                std::cout << "ERROR::BENCHMARK::KEYS_NOT_SORTED at " << path << ":" << lineNr << std::endl;
+                return false;
+            }
+            keys.push_back(key);
+        }
+        if (keys.empty()) {
+            std::cout << "ERROR::BENCHMARK::NO_KEYS in " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    float duration() const
+    {
+        return keys.empty() ? 0.0f : keys.back().time;
+    }
+
+    // samples the schedule at time t (clamped to the first/last key)
+    BenchmarkKey sample(float t) const
+    {
+        if (t <= keys.front().time) return keys.front();
+        if (t >= keys.back().time) return keys.back();
+
+        size_t i = 1;
+        while (keys[i].time < t) i++;
+        const BenchmarkKey& a = keys[i - 1];
+        const BenchmarkKey& b = keys[i];
+        float f = (t - a.time) / (b.time - a.time);
+
+        BenchmarkKey key;
+        key.time = t;
+        key.cameraPos = glm::mix(a.cameraPos, b.cameraPos, f);
+        key.cameraTarget = glm::mix(a.cameraTarget, b.cameraTarget, f);
+        key.numLayers = (int)std::round(glm::mix((float)a.numLayers, (float)b.numLayers, f));
+        key.gridFreq = glm::mix(a.gridFreq, b.gridFreq, f);
+        key.strandThickness = glm::mix(a.strandThickness, b.strandThickness, f);
+        key.furLength = glm::mix(a.furLength, b.furLength, f);
+        return key;
+    }
+};
+
+// Summary of one series of frame times in milliseconds
+struct FrameTimeStats {
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+
+    static FrameTimeStats compute(std::vector<double> samples)
+    {
+        FrameTimeStats stats;
+        if (samples.empty())
+            return stats;
+        std::sort(samples.begin(), samples.end());
+        // nearest-rank percentile
+        auto percentile = [&](double p) {
+            size_t rank = (size_t)std::ceil(p / 100.0 * samples.size());
+            return samples[std::min(samples.size() - 1, rank > 0 ? rank - 1 : 0)];
+        };
+        double sum = 0.0;
+        for (double s : samples) sum += s;
+        stats.mean = sum / samples.size();
+        stats.p50 = percentile(50.0);
+        stats.p95 = percentile(95.0);
+        stats.p99 = percentile(99.0);
+        stats.max = samples.back();
+        return stats;
+    }
+};
+
+// Per-frame timings collected during a benchmark run
+class BenchmarkRecorder {
+public:
+    std::vector<double> cpuMs;   // CPU time to record and submit the frame
+    std::vector<double> gpuMs;   // GPU time between frame start and end
+    std::vector<double> frameMs; // wall time of the whole frame
+    std::vector<std::string> passNames;    // GPU passes, see GpuTimer
+    std::vector<std::vector<double>> passMs; // [pass][GPU timed frame]
+
+    void addFrame(double cpu, double frame)
+    {
+        cpuMs.push_back(cpu);
+        frameMs.push_back(frame);
+    }
+
+    // only for frames whose GPU queries came back, so gpuMs can be shorter
+    // than frameMs. A missing timing is not a 0 ms frame
+    void addGpuFrame(double gpu, const std::vector<double>& passes = {})
+    {
+        gpuMs.push_back(gpu);
+        passMs.resize(passNames.size());
+        for (size_t i = 0; i < passNames.size(); i++)
+            passMs[i].push_back(i < passes.size() ? passes[i] : 0.0);
+    }
+
+    bool writeJSON(const std::string& path, const std::string& scriptName,
+                   const std::string& renderer, int width, int height, int warmupFrames) const
+    {
+        std::ofstream out(path);
+        if (!out) {
+            std::cout << "ERROR::BENCHMARK::COULD_NOT_OPEN " << path << std::endl;
+            return false;
+        }
+        out << "{\n";
+        out << "  \"script\": \"" << escape(scriptName) << "\",\n";
+        out << "  \"renderer\": \"" << escape(renderer) << "\",\n";
+        out << "  \"width\": " << width << ",\n";
+        out << "  \"height\": " << height << ",\n";
+        out << "  \"warmup_frames\": " << warmupFrames << ",\n";
+        out << "  \"frames\": " << frameMs.size() << ",\n";
+        out << "  \"gpu_frames\": " << gpuMs.size() << ",\n";
+        writeStats(out, "cpu_ms", FrameTimeStats::compute(cpuMs), false);
+        writeStats(out, "gpu_ms", FrameTimeStats::compute(gpuMs), false);
+        writeStats(out, "frame_ms", FrameTimeStats::compute(frameMs), passNames.empty());
+        if (!passNames.empty()) {
+            out << "  \"gpu_passes\": {\n";
+            for (size_t i = 0; i < passNames.size(); i++) {
+                out << "  ";
+                writeStats(out, escape(passNames[i]).c_str(), FrameTimeStats::compute(passMs[i]),
+                           i + 1 == passNames.size());
+            }
+            out << "  }\n";
+        }
+        out << "}\n";
+        return (bool)out;
+    }
+
+private:
+    static void writeStats(std::ofstream& out, const char* name, const FrameTimeStats& s, bool last)
+    {
+        out << "  \"" << name << "\": { "
+            << "\"mean\": " << s.mean << ", "
+            << "\"p50\": " << s.p50 << ", "
+            << "\"p95\": " << s.p95 << ", "
+            << "\"p99\": " << s.p99 << ", "
+            << "\"max\": " << s.max << " }"
+            << (last ? "\n" : ",\n");
+    }
+
+    static std::string escape(const std::string& s)
+    {
+        std::string result;
+        for (char c : s) {
+            if (c == '"' || c == '\\') result += '\\';
+            result += c;
+        }
+        return result;
+    }
+};
+#endif
@@ -0,0 +1,153 @@
+#ifndef FILL_STATS_H
+#define FILL_STATS_H
+
+#include <glad/glad.h>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Per shell layer fragment counts from GL_SAMPLES_PASSED occlusion queries.
+// Each layer is drawn on its own twice: once with a shader that never
+// discards (fragments rasterized) and once with basic.frag (fragments that
+// survive the strand test). Queries are double buffered and a frame's
+// results are only read when the driver has them ready, otherwise that
+// frame is skipped instead of stalling.
+class LayerFillStats {
+public:
+    // running totals over every counted frame, indexed by layer
+    std::vector<double> rasterized;
+    std::vector<double> survived;
+    std::vector<int> framesCounted;
+
+    LayerFillStats() = default;
+    LayerFillStats(const LayerFillStats&) = delete;
+    LayerFillStats& operator=(const LayerFillStats&) = delete;
+
+    ~LayerFillStats()
+    {
+        for (FrameQueries& frame : frames)
+            if (!frame.queries.empty())
+                glDeleteQueries((GLsizei)frame.queries.size(), frame.queries.data());
+    }
+
+    // reads last frame's results (if ready) and prepares queries for numLayers
+    void beginFrame(int numLayers)
+    {
+        collect(frames[1 - current], false);
+
+        FrameQueries& frame = frames[current];
+        if ((int)frame.queries.size() < numLayers * 2) {
+            size_t old = frame.queries.size();
+            frame.queries.resize(numLayers * 2);
+            glGenQueries((GLsizei)(frame.queries.size() - old), frame.queries.data() + old);
+        }
+        frame.layers = numLayers;
+    }
+
+    void beginRasterized(int layer) { glBeginQuery(GL_SAMPLES_PASSED, frames[current].queries[layer * 2]); }
+    void beginSurvived(int layer)   { glBeginQuery(GL_SAMPLES_PASSED, frames[current].queries[layer * 2 + 1]); }
+    void end()                      { glEndQuery(GL_SAMPLES_PASSED); }
+
+    void endFrame()
+    {
+        frames[current].pending = true;
+        current = 1 - current;
+    }
+
+    // waits for the last submitted frame, only meant for shutdown
+    void flush()
+    {
+        collect(frames[1 - current], true);
+    }
+
+    // share of rasterized fragments that survived, over all counted frames
+    double survivalRate() const
+    {
+        double r = 0.0, s = 0.0;
+        for (size_t i = 0; i < rasterized.size(); i++) {
+            r += rasterized[i];
+            s += survived[i];
+        }
+        return r > 0.0 ? s / r : 0.0;
+    }
+
+    // survival of the most recently read frame, for the HUD
+    double lastSurvivalRate() const
+    {
+        return lastRasterized > 0 ? (double)lastSurvived / lastRasterized : 0.0;
+    }
+
+    bool writeCSV(const std::string& path) const
+    {
+        std::ofstream out(path);
+        if (!out) {
+            std::cout << "ERROR::FILLSTATS::COULD_NOT_OPEN " << path << std::endl;
+            return false;
+        }
+        out << "layer,frames,avg_rasterized,avg_survived,survival_pct\n";
+        for (size_t i = 0; i < rasterized.size(); i++) {
+            if (framesCounted[i] == 0)
+                continue;
+            double r = rasterized[i] / framesCounted[i];
+            double s = survived[i] / framesCounted[i];
+            out << i << "," << framesCounted[i] << "," << r << "," << s << ","
+                << (r > 0.0 ? 100.0 * s / r : 0.0) << "\n";
+        }
+        return (bool)out;
+    }
+
+    void printSummary() const
+    {
+        double r = 0.0, s = 0.0;
+        for (size_t i = 0; i < rasterized.size(); i++) {
+            r += rasterized[i];
+            s += survived[i];
+        }
+        std::cout << "Layer fill: " << (long long)r << " fragments rasterized, "
+                  << (long long)s << " survived (" << 100.0 * survivalRate() << "%)" << std::endl;
+    }
+
+private:
+    struct FrameQueries {
+        std::vector<unsigned int> queries; // [layer * 2] rasterized, [layer * 2 + 1] survived
+        int layers = 0;
+        bool pending = false;
+    };
+
+    FrameQueries frames[2];
+    int current = 0;
+    long long lastRasterized = 0, lastSurvived = 0;
+
+    void collect(FrameQueries& frame, bool wait)
+    {
+        if (!frame.pending)
+            return;
+        frame.pending = false;
+
+        GLint available = 0;
+        if (!wait)
+            glGetQueryObjectiv(frame.queries[frame.layers * 2 - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!wait && !available)
+            return; // skip rather than wait
+
+        if ((int)rasterized.size() < frame.layers) {
+            rasterized.resize(frame.layers, 0.0);
+            survived.resize(frame.layers, 0.0);
+            framesCounted.resize(frame.layers, 0);
+        }
+        lastRasterized = lastSurvived = 0;
+        for (int layer = 0; layer < frame.layers; layer++) {
+            GLuint64 r = 0, s = 0;
+            glGetQueryObjectui64v(frame.queries[layer * 2], GL_QUERY_RESULT, &r);
+            glGetQueryObjectui64v(frame.queries[layer * 2 + 1], GL_QUERY_RESULT, &s);
+            rasterized[layer] += (double)r;
+            survived[layer] += (double)s;
+            framesCounted[layer]++;
+            lastRasterized += r;
+            lastSurvived += s;
+        }
+    }
+};
+#endif
@@ -0,0 +1,289 @@
+#ifndef FRAME_PACING_H
+#define FRAME_PACING_H
+
+#include "Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Frame to frame intervals in a fixed-width histogram, plus a hitch detector.
+// The histogram makes percentiles cheap at any time without keeping every
+// sample. A hitch is a frame that takes more than HITCH_FACTOR times the
+// average of the frames before it, so it adapts to whatever rate the app
+// normally runs at (vsync, uncapped, software rendering).
+class FramePacingStats {
+public:
+    static constexpr double BUCKET_MS = 0.1;
+    static constexpr int BUCKETS = 2500;           // 0 - 250 ms, the last bucket takes the rest
+    static constexpr int HISTORY = 32;              // frames the hitch baseline averages over
+    static constexpr double HITCH_FACTOR = 2.0;
+    static constexpr double HITCH_MIN_MS = 4.0; // ignore tiny spikes on very fast frames
+
+    struct Hitch {
+        int frame;
+        double ms;
+        double baselineMs;
+    };
+
+    long long count = 0;
+    double totalMs = 0.0;
+    double maxMs = 0.0;
+    long long hitchCount = 0;
+    std::vector<Hitch> worstHitches; // largest first, at most MAX_HITCHES
+
+    FramePacingStats() : buckets(BUCKETS, 0) {}
+
+    // returns true if the frame was a hitch
+    bool add(int frame, double ms)
+    {
+        int bucket = std::min(BUCKETS - 1, (int)(ms / BUCKET_MS));
+        buckets[std::max(0, bucket)]++;
+        count++;
+        totalMs += ms;
+        maxMs = std::max(maxMs, ms);
+
+        bool hitch = false;
+        if (historyCount == HISTORY) {
+            double baseline = historySum / HISTORY;
+            if (ms > baseline * HITCH_FACTOR && ms - baseline > HITCH_MIN_MS) {
+                hitch = true;
+                hitchCount++;
+                recordHitch({ frame, ms, baseline });
+            }
+        }
+        // hitches stay out of the baseline so a burst of them is still caught
+        if (!hitch) {
+            historySum += ms - history[historyPos];
+            history[historyPos] = ms;
+            historyPos = (historyPos + 1) % HISTORY;
+            historyCount = std::min(historyCount + 1, HISTORY);
+        }
+        return hitch;
+    }
+
+    void reset()
+    {
+        *this = FramePacingStats();
+    }
+
+    double mean() const { return count > 0 ? totalMs / count : 0.0; }
+
+    // upper edge of the bucket holding the p-th percentile
+    double percentile(double p) const
+    {
+        if (count == 0)
+            return 0.0;
+        long long rank = std::max(1LL, (long long)std::ceil(p / 100.0 * count));
+        long long seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += buckets[i];
+            if (seen >= rank)
+                return i == BUCKETS - 1 ? maxMs : std::min(maxMs, (i + 1) * BUCKET_MS);
+        }
+        return maxMs;
+    }
+
+    void printSummary(const char* label) const
+    {
+        if (count == 0)
+            return;
+        std::cout << label << ": " << count << " frames, mean " << mean() << " ms"
+                  << " p50 " << percentile(50.0) << " p90 " << percentile(90.0)
+                  << " p99 " << percentile(99.0) << " p99.9 " << percentile(99.9)
+                  << " max " << maxMs << " ms, " << hitchCount << " hitches" << std::endl;
+
+        // coarse view of the histogram around common refresh intervals
+        const double edges[] = { 0.0, 4.0, 8.33, 11.1, 16.7, 20.0, 33.3, 50.0, 100.0, 1e9 };
+        const int rows = sizeof(edges) / sizeof(edges[0]) - 1;
+        for (int r = 0; r < rows; r++) {
+            long long n = 0;
+            for (int i = 0; i < BUCKETS; i++) {
+                double lo = i * BUCKET_MS;
+                if (lo >= edges[r] && lo < edges[r + 1])
+                    n += buckets[i];
+            }
+            if (n == 0)
+                continue;
+            char line[64];
+            if (edges[r + 1] > 1e8)
+                snprintf(line, sizeof(line), "  >%6.1f ms %7lld ", edges[r], n);
+            else
+                snprintf(line, sizeof(line), "  <%6.1f ms %7lld ", edges[r + 1], n);
+            std::cout << line << std::string((size_t)(50.0 * n / count + 0.5), '#') << std::endl;
+        }
+        for (const Hitch& h : worstHitches) {
+            std::cout << "  hitch at frame " << h.frame << ": " << h.ms
+                      << " ms (baseline " << h.baselineMs << " ms)" << std::endl;
+        }
+    }
+
+private:
+    static constexpr size_t MAX_HITCHES = 5;
+
+    std::vector<long long> buckets;
+    double history[HISTORY] = {};
+    double historySum = 0.0;
+    int historyPos = 0;
+    int historyCount = 0;
+
+    void recordHitch(const Hitch& hitch)
+    {
+        worstHitches.push_back(hitch);
+        std::sort(worstHitches.begin(), worstHitches.end(),
+                  [](const Hitch& a, const Hitch& b) { return a.ms > b.ms; });
+        if (worstHitches.size() > MAX_HITCHES)
+            worstHitches.pop_back();
+    }
+};
+
+// One record in the binary frame log
+struct FrameLogEntry {
+    uint32_t frame;
+    float dtMs;         // wall time since the previous frame started
+    float cpuMs;        // time to record and submit the frame
+    float gpuMs;        // -1 when the GPU timing was dropped
+    uint32_t numLayers;
+};
+static_assert(sizeof(FrameLogEntry) == 20, "frame log records are read back as 20 byte structs");
+
+// Binary per-frame log written by a background thread.
+// The render thread only copies an entry into a single producer / single
+// consumer ring, which never locks or blocks; if the writer falls behind and
+// the ring is full the entry is counted as dropped instead. GPU times arrive
+// a few frames late (see GpuTimer), so entries wait in a small pending queue
+// until their GPU time is known.
+//
+// File layout (little endian): "SHFL", uint32 version, uint32 record size,
+// then FrameLogEntry records back to back.
+class FrameLog {
+public:
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t RING_SIZE = 4096; // power of two
+
+    FrameLog() = default;
+    FrameLog(const FrameLog&) = delete;
+    FrameLog& operator=(const FrameLog&) = delete;
+
+    ~FrameLog()
+    {
+        close();
+    }
+
+    bool open(const std::string& path)
+    {
+        file.open(path, std::ios::binary);
+        if (!file) {
+            std::cout << "ERROR::FRAMELOG::COULD_NOT_OPEN " << path << std::endl;
+            return false;
+        }
+        const uint32_t header[3] = { 0x4C464853u /* "SHFL" */, VERSION, (uint32_t)sizeof(FrameLogEntry) };
+        file.write((const char*)header, sizeof(header));
+        running.store(true, std::memory_order_release);
+        writer = std::thread(&FrameLog::writerLoop, this);
+        return true;
+    }
+
+    bool isOpen() const { return writer.joinable(); }
+
+    // render thread: CPU side of a frame, held until addGpu sees its GPU time
+    void addFrame(int frame, double dtMs, double cpuMs, int numLayers)
+    {
+        if (!isOpen())
+            return;
+        pending.push_back({ (uint32_t)frame, (float)dtMs, (float)cpuMs, -1.0f, (uint32_t)numLayers });
+        if (pending.size() > MAX_PENDING) { // GPU timings stopped arriving
+            push(pending.front());
+            pending.pop_front();
+        }
+    }
+
+    // render thread: GPU timings arrive in frame order
+    void addGpu(int frame, double gpuMs)
+    {
+        while (!pending.empty() && (int)pending.front().frame <= frame) {
+            if ((int)pending.front().frame == frame)
+                pending.front().gpuMs = (float)gpuMs;
+            push(pending.front());
+            pending.pop_front();
+        }
+    }
+
+    // flushes everything still pending and stops the writer thread
+    void close()
+    {
+        if (!isOpen())
+            return;
+        for (const FrameLogEntry& entry : pending)
+            push(entry);
+        pending.clear();
+        running.store(false, std::memory_order_release);
+        writer.join();
+        file.close();
+        size_t lost = dropped.load(std::memory_order_relaxed);
+        std::cout << "Frame log: " << written << " frames written";
+        if (lost > 0)
+            std::cout << " (" << lost << " dropped, writer fell behind)";
+        std::cout << std::endl;
+    }
+
+private:
+    static constexpr size_t MAX_PENDING = 64;
+
+    FrameLogEntry ring[RING_SIZE];
+    alignas(64) std::atomic<size_t> head{0}; // next slot to write, owned by the render thread
+    alignas(64) std::atomic<size_t> tail{0}; // next slot to read, owned by the writer
+    std::atomic<size_t> dropped{0};
+    std::atomic<bool> running{false};
+
+    std::deque<FrameLogEntry> pending; // render thread only
+    std::thread writer;
+    std::ofstream file;                // writer thread only while running
+    size_t written = 0;
+
+    void push(const FrameLogEntry& entry)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == RING_SIZE) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ring[h & (RING_SIZE - 1)] = entry;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    void drain()
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        if (t == h)
+            return;
+        PROFILE_SCOPE("frame log drain");
+        for (; t != h; t++) {
+            file.write((const char*)&ring[t & (RING_SIZE - 1)], sizeof(FrameLogEntry));
+            written++;
+        }
+        tail.store(t, std::memory_order_release);
+    }
+
+    void writerLoop()
+    {
+        Profiler::setThreadName("frame log");
+        while (running.load(std::memory_order_acquire)) {
+            drain();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        drain(); // whatever close() pushed last
+        file.flush();
+    }
+};
+#endif
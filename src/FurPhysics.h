@@ -0,0 +1,32 @@
+#ifndef FUR_PHYSICS_H
+#define FUR_PHYSICS_H
+
+#include <glm/glm.hpp>
+
+#include "Profiler.h"
+
+// Wind that bends the shells, driven by how fast the camera moves
+struct FurPhysics {
+    glm::vec3 lastCameraPos = glm::vec3(0.0f); // allows for velocity calculation
+    glm::vec3 windDirection = glm::vec3(0.0f); // used for hair physics
+
+    void update(const glm::vec3& cameraPos, float deltaTime)
+    {
+        PROFILE_SCOPE("updateFurPhysics");
+        // calculate velocity based on camera position
+        glm::vec3 velocity = (cameraPos - lastCameraPos) / deltaTime;
+        lastCameraPos = cameraPos;
+
+        // smooths the wind direction
+        float smoothing = 0.9f;
+        glm::vec3 targetWind = -velocity;
+        windDirection = glm::mix(targetWind, windDirection, smoothing);
+
+        // Clamp maximum strength
+        float maxWindStrength = 2.0f;
+        if(glm::length(windDirection) > maxWindStrength) {
+            windDirection = glm::normalize(windDirection) * maxWindStrength;
+        }
+    }
+};
+#endif
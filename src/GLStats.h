@@ -0,0 +1,583 @@
+#ifndef GL_STATS_H
+#define GL_STATS_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+// Counts of one frame's GL traffic (or the sum over many frames)
+struct GLCounters {
+    long long draws = 0;
+    long long instances = 0;          // instances submitted by all draws
+    long long uniformUploads = 0;
+    long long uniformRedundant = 0;   // same value the location already had
+    long long uniformInactive = 0;    // location -1, the uniform was optimized out
+    long long uniformLookups = 0;     // glGetUniformLocation
+    long long programBinds = 0;
+    long long programRedundant = 0;
+    long long vaoBinds = 0;
+    long long vaoRedundant = 0;
+    long long bufferBinds = 0;
+    long long bufferRedundant = 0;
+    long long textureBinds = 0;       // includes glActiveTexture
+    long long textureRedundant = 0;
+    long long framebufferBinds = 0;
+    long long framebufferRedundant = 0;
+    long long stateToggles = 0;       // enable/disable, masks, blend func, viewport
+    long long stateRedundant = 0;
+    long long bytesUploaded = 0;      // buffer and texture data
+
+    void add(const GLCounters& o)
+    {
+        draws += o.draws; instances += o.instances;
+        uniformUploads += o.uniformUploads; uniformRedundant += o.uniformRedundant;
+        uniformInactive += o.uniformInactive; uniformLookups += o.uniformLookups;
+        programBinds += o.programBinds; programRedundant += o.programRedundant;
+        vaoBinds += o.vaoBinds; vaoRedundant += o.vaoRedundant;
+        bufferBinds += o.bufferBinds; bufferRedundant += o.bufferRedundant;
+        textureBinds += o.textureBinds; textureRedundant += o.textureRedundant;
+        framebufferBinds += o.framebufferBinds; framebufferRedundant += o.framebufferRedundant;
+        stateToggles += o.stateToggles; stateRedundant += o.stateRedundant;
+        bytesUploaded += o.bytesUploaded;
+    }
+};
+
+// Optional GL call accounting.
+// install() swaps GLAD's function pointers for wrappers that count the call,
+// compare it against a shadow copy of the state it changes and then forward
+// to the driver. Nothing is touched unless install() is called, so the
+// normal path pays nothing. The shadow state assumes every GL call goes
+// through GLAD after install(), which is true for this app.
+class GLStats {
+public:
+    static inline GLCounters frame;  // current frame so far
+    static inline GLCounters last;   // last finished frame
+    static inline GLCounters total;  // every finished frame
+    static inline long long frames = 0;
+    static inline bool installed = false;
+
+    // call right after gladLoadGLLoader, while the context is in its default state
+    static void install()
+    {
+        if (installed)
+            return;
+        installed = true;
+#define GLSTATS_HOOK(name) real.name = glad_##name; glad_##name = hook_##name
+        GLSTATS_HOOK(glDrawArrays);
+        GLSTATS_HOOK(glDrawElements);
+        GLSTATS_HOOK(glDrawArraysInstanced);
+        GLSTATS_HOOK(glDrawElementsInstanced);
+        GLSTATS_HOOK(glDrawElementsBaseVertex);
+        GLSTATS_HOOK(glDrawElementsInstancedBaseVertex);
+        GLSTATS_HOOK(glMultiDrawElementsBaseVertex);
+        GLSTATS_HOOK(glGetUniformLocation);
+        GLSTATS_HOOK(glUniform1i);
+        GLSTATS_HOOK(glUniform1f);
+        GLSTATS_HOOK(glUniform2f);
+        GLSTATS_HOOK(glUniform3f);
+        GLSTATS_HOOK(glUniform4f);
+        GLSTATS_HOOK(glUniform1iv);
+        GLSTATS_HOOK(glUniform1fv);
+        GLSTATS_HOOK(glUniform2fv);
+        GLSTATS_HOOK(glUniform3fv);
+        GLSTATS_HOOK(glUniform4fv);
+        GLSTATS_HOOK(glUniformMatrix2fv);
+        GLSTATS_HOOK(glUniformMatrix3fv);
+        GLSTATS_HOOK(glUniformMatrix4fv);
+        GLSTATS_HOOK(glUseProgram);
+        GLSTATS_HOOK(glBindVertexArray);
+        GLSTATS_HOOK(glBindBuffer);
+        GLSTATS_HOOK(glBindBufferBase);
+        GLSTATS_HOOK(glBindBufferRange);
+        GLSTATS_HOOK(glActiveTexture);
+        GLSTATS_HOOK(glBindTexture);
+        GLSTATS_HOOK(glBindFramebuffer);
+        GLSTATS_HOOK(glEnable);
+        GLSTATS_HOOK(glDisable);
+        GLSTATS_HOOK(glDepthMask);
+        GLSTATS_HOOK(glColorMask);
+        GLSTATS_HOOK(glBlendFunc);
+        GLSTATS_HOOK(glViewport);
+        GLSTATS_HOOK(glBufferData);
+        GLSTATS_HOOK(glBufferSubData);
+        GLSTATS_HOOK(glTexImage2D);
+        GLSTATS_HOOK(glTexSubImage2D);
+        GLSTATS_HOOK(glLinkProgram);
+        GLSTATS_HOOK(glDeleteProgram);
+        GLSTATS_HOOK(glDeleteVertexArrays);
+        GLSTATS_HOOK(glDeleteBuffers);
+        GLSTATS_HOOK(glDeleteTextures);
+        GLSTATS_HOOK(glDeleteFramebuffers);
+#undef GLSTATS_HOOK
+    }
+
+    static void endFrame()
+    {
+        last = frame;
+        total.add(frame);
+        frames++;
+        frame = GLCounters();
+    }
+
+    // one line for the window title
+    static std::string titleText()
+    {
+        char text[128];
+        snprintf(text, sizeof(text), " | draws %lld uniforms %lld (%lld redundant) binds %lld",
+                 last.draws, last.uniformUploads, last.uniformRedundant,
+                 last.programBinds + last.vaoBinds + last.bufferBinds + last.textureBinds + last.framebufferBinds);
+        return text;
+    }
+
+    static void printSummary()
+    {
+        if (frames == 0)
+            return;
+        std::cout << "GL calls over " << frames << " frames (per frame avg, redundant per frame avg):" << std::endl;
+        auto row = [](const char* name, long long count, long long redundant, bool hasRedundant) {
+            char line[128];
+            if (hasRedundant)
+                snprintf(line, sizeof(line), "  %-20s %10.1f %10.1f", name,
+                         (double)count / frames, (double)redundant / frames);
+            else
+                snprintf(line, sizeof(line), "  %-20s %10.1f", name, (double)count / frames);
+            std::cout << line << std::endl;
+        };
+        row("draws", total.draws, 0, false);
+        row("instances", total.instances, 0, false);
+        row("uniform uploads", total.uniformUploads, total.uniformRedundant, true);
+        row("uniform inactive", total.uniformInactive, 0, false);
+        row("uniform lookups", total.uniformLookups, 0, false);
+        row("program binds", total.programBinds, total.programRedundant, true);
+        row("vao binds", total.vaoBinds, total.vaoRedundant, true);
+        row("buffer binds", total.bufferBinds, total.bufferRedundant, true);
+        row("texture binds", total.textureBinds, total.textureRedundant, true);
+        row("framebuffer binds", total.framebufferBinds, total.framebufferRedundant, true);
+        row("state changes", total.stateToggles, total.stateRedundant, true);
+        row("bytes uploaded", total.bytesUploaded, 0, false);
+    }
+
+private:
+    struct RealFunctions {
+        PFNGLDRAWARRAYSPROC glDrawArrays;
+        PFNGLDRAWELEMENTSPROC glDrawElements;
+        PFNGLDRAWARRAYSINSTANCEDPROC glDrawArraysInstanced;
+        PFNGLDRAWELEMENTSINSTANCEDPROC glDrawElementsInstanced;
+        PFNGLDRAWELEMENTSBASEVERTEXPROC glDrawElementsBaseVertex;
+        PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXPROC glDrawElementsInstancedBaseVertex;
+        PFNGLMULTIDRAWELEMENTSBASEVERTEXPROC glMultiDrawElementsBaseVertex;
+        PFNGLGETUNIFORMLOCATIONPROC glGetUniformLocation;
+        PFNGLUNIFORM1IPROC glUniform1i;
+        PFNGLUNIFORM1FPROC glUniform1f;
+        PFNGLUNIFORM2FPROC glUniform2f;
+        PFNGLUNIFORM3FPROC glUniform3f;
+        PFNGLUNIFORM4FPROC glUniform4f;
+        PFNGLUNIFORM1IVPROC glUniform1iv;
+        PFNGLUNIFORM1FVPROC glUniform1fv;
+        PFNGLUNIFORM2FVPROC glUniform2fv;
+        PFNGLUNIFORM3FVPROC glUniform3fv;
+        PFNGLUNIFORM4FVPROC glUniform4fv;
+        PFNGLUNIFORMMATRIX2FVPROC glUniformMatrix2fv;
+        PFNGLUNIFORMMATRIX3FVPROC glUniformMatrix3fv;
+        PFNGLUNIFORMMATRIX4FVPROC glUniformMatrix4fv;
+        PFNGLUSEPROGRAMPROC glUseProgram;
+        PFNGLBINDVERTEXARRAYPROC glBindVertexArray;
+        PFNGLBINDBUFFERPROC glBindBuffer;
+        PFNGLBINDBUFFERBASEPROC glBindBufferBase;
+        PFNGLBINDBUFFERRANGEPROC glBindBufferRange;
+        PFNGLACTIVETEXTUREPROC glActiveTexture;
+        PFNGLBINDTEXTUREPROC glBindTexture;
+        PFNGLBINDFRAMEBUFFERPROC glBindFramebuffer;
+        PFNGLENABLEPROC glEnable;
+        PFNGLDISABLEPROC glDisable;
+        PFNGLDEPTHMASKPROC glDepthMask;
+        PFNGLCOLORMASKPROC glColorMask;
+        PFNGLBLENDFUNCPROC glBlendFunc;
+        PFNGLVIEWPORTPROC glViewport;
+        PFNGLBUFFERDATAPROC glBufferData;
+        PFNGLBUFFERSUBDATAPROC glBufferSubData;
+        PFNGLTEXIMAGE2DPROC glTexImage2D;
+        PFNGLTEXSUBIMAGE2DPROC glTexSubImage2D;
+        PFNGLLINKPROGRAMPROC glLinkProgram;
+        PFNGLDELETEPROGRAMPROC glDeleteProgram;
+        PFNGLDELETEVERTEXARRAYSPROC glDeleteVertexArrays;
+        PFNGLDELETEBUFFERSPROC glDeleteBuffers;
+        PFNGLDELETETEXTURESPROC glDeleteTextures;
+        PFNGLDELETEFRAMEBUFFERSPROC glDeleteFramebuffers;
+    };
+    static inline RealFunctions real = {};
+
+    // shadow of the state the wrappers compare against
+    struct UniformValue {
+        uint32_t words[16];
+        int count;
+    };
+    static inline GLuint program = 0;
+    static inline GLuint vao = 0;
+    static inline GLenum activeUnit = 0;
+    static inline GLuint drawFramebuffer = 0, readFramebuffer = 0;
+    static inline std::unordered_map<GLenum, GLuint> buffers;      // target -> buffer
+    static inline std::unordered_map<uint64_t, GLuint> textures;   // unit << 32 | target -> texture
+    static inline std::unordered_map<GLenum, bool> caps;           // glEnable/glDisable
+    static inline std::unordered_map<uint64_t, UniformValue> uniforms; // program << 32 | location
+    static inline GLboolean depthMask = GL_TRUE;
+    static inline GLboolean colorMask[4] = { GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE };
+    static inline GLenum blendSrc = GL_ONE, blendDst = GL_ZERO;
+    static inline GLint viewport[4] = { -1, -1, -1, -1 }; // unknown until the first call
+
+    // counts the upload and reports whether it changed anything
+    static void uniform(GLint location, const void* data, int words)
+    {
+        frame.uniformUploads++;
+        if (location < 0) {
+            frame.uniformInactive++;
+            return;
+        }
+        uint64_t key = ((uint64_t)program << 32) | (uint32_t)location;
+        UniformValue& value = uniforms[key];
+        if (words <= 16) {
+            if (value.count == words && memcmp(value.words, data, words * 4) == 0) {
+                frame.uniformRedundant++;
+                return;
+            }
+            memcpy(value.words, data, words * 4);
+            value.count = words;
+        }
+    }
+
+    static void toggle(bool redundant)
+    {
+        frame.stateToggles++;
+        if (redundant)
+            frame.stateRedundant++;
+    }
+
+    static long long pixelBytes(GLsizei w, GLsizei h, GLenum format, GLenum type)
+    {
+        int components = 4;
+        switch (format) {
+        case GL_RED: case GL_DEPTH_COMPONENT: components = 1; break;
+        case GL_RG: case GL_DEPTH_STENCIL: components = 2; break;
+        case GL_RGB: components = 3; break;
+        }
+        int size = 1;
+        switch (type) {
+        case GL_HALF_FLOAT: case GL_UNSIGNED_SHORT: case GL_SHORT: size = 2; break;
+        case GL_FLOAT: case GL_UNSIGNED_INT: case GL_INT: size = 4; break;
+        }
+        return (long long)w * h * components * size;
+    }
+
+    static void APIENTRY hook_glDrawArrays(GLenum mode, GLint first, GLsizei count)
+    {
+        frame.draws++; frame.instances++;
+        real.glDrawArrays(mode, first, count);
+    }
+    static void APIENTRY hook_glDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+    {
+        frame.draws++; frame.instances++;
+        real.glDrawElements(mode, count, type, indices);
+    }
+    static void APIENTRY hook_glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances)
+    {
+        frame.draws++; frame.instances += instances;
+        real.glDrawArraysInstanced(mode, first, count, instances);
+    }
+    static void APIENTRY hook_glDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type,
+                                                      const void* indices, GLsizei instances)
+    {
+        frame.draws++; frame.instances += instances;
+        real.glDrawElementsInstanced(mode, count, type, indices, instances);
+    }
+    static void APIENTRY hook_glDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type,
+                                                       const void* indices, GLint baseVertex)
+    {
+        frame.draws++; frame.instances++;
+        real.glDrawElementsBaseVertex(mode, count, type, indices, baseVertex);
+    }
+    static void APIENTRY hook_glDrawElementsInstancedBaseVertex(GLenum mode, GLsizei count, GLenum type,
+                                                                const void* indices, GLsizei instances,
+                                                                GLint baseVertex)
+    {
+        frame.draws++; frame.instances += instances;
+        real.glDrawElementsInstancedBaseVertex(mode, count, type, indices, instances, baseVertex);
+    }
+    // one call, but the driver still walks drawCount draws
+    static void APIENTRY hook_glMultiDrawElementsBaseVertex(GLenum mode, const GLsizei* count, GLenum type,
+                                                            const void* const* indices, GLsizei drawCount,
+                                                            const GLint* baseVertex)
+    {
+        frame.draws++; frame.instances += drawCount;
+        real.glMultiDrawElementsBaseVertex(mode, count, type, indices, drawCount, baseVertex);
+    }
+
+    static GLint APIENTRY hook_glGetUniformLocation(GLuint prog, const GLchar* name)
+    {
+        frame.uniformLookups++;
+        return real.glGetUniformLocation(prog, name);
+    }
+    static void APIENTRY hook_glUniform1i(GLint loc, GLint v)
+    {
+        uniform(loc, &v, 1);
+        real.glUniform1i(loc, v);
+    }
+    static void APIENTRY hook_glUniform1f(GLint loc, GLfloat v)
+    {
+        uniform(loc, &v, 1);
+        real.glUniform1f(loc, v);
+    }
+    static void APIENTRY hook_glUniform2f(GLint loc, GLfloat x, GLfloat y)
+    {
+        GLfloat v[2] = { x, y };
+        uniform(loc, v, 2);
+        real.glUniform2f(loc, x, y);
+    }
+    static void APIENTRY hook_glUniform3f(GLint loc, GLfloat x, GLfloat y, GLfloat z)
+    {
+        GLfloat v[3] = { x, y, z };
+        uniform(loc, v, 3);
+        real.glUniform3f(loc, x, y, z);
+    }
+    static void APIENTRY hook_glUniform4f(GLint loc, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+    {
+        GLfloat v[4] = { x, y, z, w };
+        uniform(loc, v, 4);
+        real.glUniform4f(loc, x, y, z, w);
+    }
+    static void APIENTRY hook_glUniform1iv(GLint loc, GLsizei count, const GLint* v)
+    {
+        uniform(loc, v, count);
+        real.glUniform1iv(loc, count, v);
+    }
+    static void APIENTRY hook_glUniform1fv(GLint loc, GLsizei count, const GLfloat* v)
+    {
+        uniform(loc, v, count);
+        real.glUniform1fv(loc, count, v);
+    }
+    static void APIENTRY hook_glUniform2fv(GLint loc, GLsizei count, const GLfloat* v)
+    {
+        uniform(loc, v, 2 * count);
+        real.glUniform2fv(loc, count, v);
+    }
+    static void APIENTRY hook_glUniform3fv(GLint loc, GLsizei count, const GLfloat* v)
+    {
+        uniform(loc, v, 3 * count);
+        real.glUniform3fv(loc, count, v);
+    }
+    static void APIENTRY hook_glUniform4fv(GLint loc, GLsizei count, const GLfloat* v)
+    {
+        uniform(loc, v, 4 * count);
+        real.glUniform4fv(loc, count, v);
+    }
+    static void APIENTRY hook_glUniformMatrix2fv(GLint loc, GLsizei count, GLboolean transpose, const GLfloat* v)
+    {
+        uniform(loc, v, 4 * count);
+        real.glUniformMatrix2fv(loc, count, transpose, v);
+    }
+    static void APIENTRY hook_glUniformMatrix3fv(GLint loc, GLsizei count, GLboolean transpose, const GLfloat* v)
+    {
+        uniform(loc, v, 9 * count);
+        real.glUniformMatrix3fv(loc, count, transpose, v);
+    }
+    static void APIENTRY hook_glUniformMatrix4fv(GLint loc, GLsizei count, GLboolean transpose, const GLfloat* v)
+    {
+        uniform(loc, v, 16 * count);
+        real.glUniformMatrix4fv(loc, count, transpose, v);
+    }
+
+    static void APIENTRY hook_glUseProgram(GLuint prog)
+    {
+        frame.programBinds++;
+        if (prog == program) frame.programRedundant++;
+        program = prog;
+        real.glUseProgram(prog);
+    }
+    static void APIENTRY hook_glBindVertexArray(GLuint array)
+    {
+        frame.vaoBinds++;
+        if (array == vao) frame.vaoRedundant++;
+        else buffers.erase(GL_ELEMENT_ARRAY_BUFFER); // the index buffer binding is VAO state
+        vao = array;
+        real.glBindVertexArray(array);
+    }
+    static void APIENTRY hook_glBindBuffer(GLenum target, GLuint buffer)
+    {
+        frame.bufferBinds++;
+        auto it = buffers.find(target);
+        if (it != buffers.end() && it->second == buffer) frame.bufferRedundant++;
+        buffers[target] = buffer;
+        real.glBindBuffer(target, buffer);
+    }
+    // indexed binds also change the generic binding point
+    static void APIENTRY hook_glBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+    {
+        frame.bufferBinds++;
+        buffers[target] = buffer;
+        real.glBindBufferBase(target, index, buffer);
+    }
+    static void APIENTRY hook_glBindBufferRange(GLenum target, GLuint index, GLuint buffer,
+                                                GLintptr offset, GLsizeiptr size)
+    {
+        frame.bufferBinds++;
+        buffers[target] = buffer;
+        real.glBindBufferRange(target, index, buffer, offset, size);
+    }
+    static void APIENTRY hook_glActiveTexture(GLenum unit)
+    {
+        frame.textureBinds++;
+        if (unit - GL_TEXTURE0 == activeUnit) frame.textureRedundant++;
+        activeUnit = unit - GL_TEXTURE0;
+        real.glActiveTexture(unit);
+    }
+    static void APIENTRY hook_glBindTexture(GLenum target, GLuint texture)
+    {
+        frame.textureBinds++;
+        uint64_t key = ((uint64_t)activeUnit << 32) | target;
+        auto it = textures.find(key);
+        if (it != textures.end() && it->second == texture) frame.textureRedundant++;
+        textures[key] = texture;
+        real.glBindTexture(target, texture);
+    }
+    static void APIENTRY hook_glBindFramebuffer(GLenum target, GLuint fbo)
+    {
+        frame.framebufferBinds++;
+        bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+        bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+        if ((!draw || drawFramebuffer == fbo) && (!read || readFramebuffer == fbo))
+            frame.framebufferRedundant++;
+        if (draw) drawFramebuffer = fbo;
+        if (read) readFramebuffer = fbo;
+        real.glBindFramebuffer(target, fbo);
+    }
+
+    static void APIENTRY hook_glEnable(GLenum cap)
+    {
+        auto it = caps.find(cap);
+        toggle(it != caps.end() && it->second);
+        caps[cap] = true;
+        real.glEnable(cap);
+    }
+    static void APIENTRY hook_glDisable(GLenum cap)
+    {
+        auto it = caps.find(cap);
+        toggle(it != caps.end() && !it->second);
+        caps[cap] = false;
+        real.glDisable(cap);
+    }
+    static void APIENTRY hook_glDepthMask(GLboolean flag)
+    {
+        toggle(flag == depthMask);
+        depthMask = flag;
+        real.glDepthMask(flag);
+    }
+    static void APIENTRY hook_glColorMask(GLboolean r, GLboolean g, GLboolean b, GLboolean a)
+    {
+        toggle(colorMask[0] == r && colorMask[1] == g && colorMask[2] == b && colorMask[3] == a);
+        colorMask[0] = r; colorMask[1] = g; colorMask[2] = b; colorMask[3] = a;
+        real.glColorMask(r, g, b, a);
+    }
+    static void APIENTRY hook_glBlendFunc(GLenum src, GLenum dst)
+    {
+        toggle(src == blendSrc && dst == blendDst);
+        blendSrc = src;
+        blendDst = dst;
+        real.glBlendFunc(src, dst);
+    }
+    static void APIENTRY hook_glViewport(GLint x, GLint y, GLsizei w, GLsizei h)
+    {
+        toggle(viewport[0] == x && viewport[1] == y && viewport[2] == w && viewport[3] == h);
+        viewport[0] = x; viewport[1] = y; viewport[2] = w; viewport[3] = h;
+        real.glViewport(x, y, w, h);
+    }
+
+    static void APIENTRY hook_glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+    {
+        if (data) frame.bytesUploaded += size;
+        real.glBufferData(target, size, data, usage);
+    }
+    static void APIENTRY hook_glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+    {
+        frame.bytesUploaded += size;
+        real.glBufferSubData(target, offset, size, data);
+    }
+    static void APIENTRY hook_glTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei w, GLsizei h,
+                                           GLint border, GLenum format, GLenum type, const void* pixels)
+    {
+        if (pixels) frame.bytesUploaded += pixelBytes(w, h, format, type);
+        real.glTexImage2D(target, level, internalFormat, w, h, border, format, type, pixels);
+    }
+    static void APIENTRY hook_glTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei w, GLsizei h,
+                                              GLenum format, GLenum type, const void* pixels)
+    {
+        frame.bytesUploaded += pixelBytes(w, h, format, type);
+        real.glTexSubImage2D(target, level, x, y, w, h, format, type, pixels);
+    }
+
+    // Deleted names can be handed out again by the next glGen*/glCreate*, so
+    // the shadow must not remember them: a fresh object bound under a
+    // recycled name is not a redundant bind. Deleting a bound object binds 0
+    // in its place, and a (re)link resets every uniform to its default
+    static void forgetUniforms(GLuint prog)
+    {
+        for (auto it = uniforms.begin(); it != uniforms.end();) {
+            if ((GLuint)(it->first >> 32) == prog)
+                it = uniforms.erase(it);
+            else
+                ++it;
+        }
+    }
+    static void APIENTRY hook_glLinkProgram(GLuint prog)
+    {
+        forgetUniforms(prog);
+        real.glLinkProgram(prog);
+    }
+    // a program still in use stays bound until something else is, so only
+    // its uniforms go
+    static void APIENTRY hook_glDeleteProgram(GLuint prog)
+    {
+        forgetUniforms(prog);
+        real.glDeleteProgram(prog);
+    }
+    static void APIENTRY hook_glDeleteVertexArrays(GLsizei n, const GLuint* arrays)
+    {
+        for (GLsizei i = 0; i < n; i++) {
+            if (arrays[i] != 0 && arrays[i] == vao) {
+                vao = 0;
+                buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+            }
+        }
+        real.glDeleteVertexArrays(n, arrays);
+    }
+    static void APIENTRY hook_glDeleteBuffers(GLsizei n, const GLuint* names)
+    {
+        for (GLsizei i = 0; i < n; i++)
+            for (auto& binding : buffers)
+                if (names[i] != 0 && binding.second == names[i])
+                    binding.second = 0;
+        real.glDeleteBuffers(n, names);
+    }
+    static void APIENTRY hook_glDeleteTextures(GLsizei n, const GLuint* names)
+    {
+        for (GLsizei i = 0; i < n; i++)
+            for (auto& binding : textures)
+                if (names[i] != 0 && binding.second == names[i])
+                    binding.second = 0;
+        real.glDeleteTextures(n, names);
+    }
+    static void APIENTRY hook_glDeleteFramebuffers(GLsizei n, const GLuint* names)
+    {
+        for (GLsizei i = 0; i < n; i++) {
+            if (names[i] == 0)
+                continue;
+            if (drawFramebuffer == names[i]) drawFramebuffer = 0;
+            if (readFramebuffer == names[i]) readFramebuffer = 0;
+        }
+        real.glDeleteFramebuffers(n, names);
+    }
+};
+#endif
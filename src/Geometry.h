@@ -0,0 +1,61 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "Mesh.h"
+
+#include <cmath>
+#include <vector>
+
+// UV sphere, stacks run pole to pole and slices around the equator.
+// Seam vertices are duplicated so texture coordinates wrap cleanly
+inline void generateSphere(float radius, int stacks, int slices,
+                           std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    vertices.clear();
+    indices.clear();
+    vertices.reserve((size_t)(stacks + 1) * (slices + 1));
+    indices.reserve((size_t)stacks * slices * 6);
+
+    // Gets the Vertices
+    for (int i = 0; i <= stacks; i++)
+    {
+        float v = float(i) / stacks;
+        float phi = v * glm::pi<float>(); // 0 --> PI
+
+        for(int j = 0; j <= slices; j++)
+        {
+            float u = float(j) / slices;
+            float theta = u * glm::two_pi<float>();
+
+            float x = sin(phi) * cos(theta);
+            float y = cos(phi);
+            float z = sin(phi) * sin(theta);
+
+            Vertex vert;
+            vert.Position = radius * glm::vec3(x, y, z);
+            vert.Normal = glm::normalize(glm::vec3(x, y, z));
+            vert.TexCoords = glm::vec2(u, v);
+
+            vertices.push_back(vert);
+        }
+    }
+    // Gets Sphere Indices
+    for(int i = 0; i < stacks; i++) {
+        for(int j = 0; j < slices; j++) {
+            int first = i * (slices + 1) + j;
+            int second = first + slices + 1;
+
+            indices.push_back(first);
+            indices.push_back(second);
+            indices.push_back(first + 1);
+
+            indices.push_back(second);
+            indices.push_back(second + 1);
+            indices.push_back(first + 1);
+        }
+    }
+}
+#endif
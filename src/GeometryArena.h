@@ -0,0 +1,367 @@
+#ifndef GEOMETRY_ARENA_H
+#define GEOMETRY_ARENA_H
+
+#include <glad/glad.h>
+
+#include "VertexLayout.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// ARB_multi_draw_indirect (core in 4.3), not part of the GLAD 3.3 loader
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+// First fit over [0, capacity) in whole elements (vertices or indices).
+// The free ranges stay sorted and never touch, release() merges neighbours
+class ArenaRanges {
+public:
+    size_t capacity = 0;
+    size_t used = 0;
+
+    bool allocate(size_t size, size_t& offset)
+    {
+        for (size_t i = 0; i < free.size(); i++) {
+            Range& range = free[i];
+            if (range.size < size)
+                continue;
+            offset = range.offset;
+            range.offset += size;
+            range.size -= size;
+            if (range.size == 0)
+                free.erase(free.begin() + i);
+            used += size;
+            return true;
+        }
+        return false;
+    }
+
+    void release(size_t offset, size_t size)
+    {
+        if (size == 0)
+            return;
+        used -= size;
+        auto next = std::lower_bound(free.begin(), free.end(), offset,
+                                     [](const Range& range, size_t at) { return range.offset < at; });
+        auto at = free.insert(next, { offset, size });
+        if (at + 1 != free.end() && at->offset + at->size == (at + 1)->offset) {
+            at->size += (at + 1)->size;
+            free.erase(at + 1);
+        }
+        if (at != free.begin() && (at - 1)->offset + (at - 1)->size == at->offset) {
+            (at - 1)->size += at->size;
+            free.erase(at);
+        }
+    }
+
+    // the new space is free, joined to a free range at the old end
+    void grow(size_t newCapacity)
+    {
+        if (newCapacity <= capacity)
+            return;
+        size_t oldCapacity = capacity;
+        capacity = newCapacity;
+        used += newCapacity - oldCapacity; // release() takes it off again
+        release(oldCapacity, newCapacity - oldCapacity);
+    }
+
+    size_t freeRanges() const { return free.size(); }
+
+private:
+    struct Range {
+        size_t offset, size;
+    };
+    std::vector<Range> free;
+};
+
+// One vertex buffer per stream and one index buffer that many meshes
+// sub-allocate from, behind a single VAO. A mesh is then just where its
+// vertices and indices start, indices stay relative to the mesh and the
+// base vertex offsets them, so uploading is a glBufferSubData each. A model
+// drawn from one arena binds the VAO once and submits every mesh with one
+// glMultiDrawElementsBaseVertex, or glMultiDrawElementsIndirect when
+// instanced and the driver has it.
+// When a mesh doesn't fit, the buffers are replaced with bigger ones and the
+// contents copied over on the GPU (glCopyBufferSubData), so allocations
+// keep their offsets. Indices are 32 bit: one arena holds many meshes.
+// STREAMS_SHELL_QUANTIZED is not supported, it decodes against bounds that
+// differ per mesh and one draw only gets one set of uniforms
+class GeometryArena {
+public:
+    struct Allocation {
+        size_t firstVertex = 0, vertexCount = 0;
+        size_t firstIndex = 0, indexCount = 0;
+    };
+
+    static inline bool indirectAvailable = false;
+
+    // call after gladLoadGLLoader with the same loader
+    static void init(GLADloadproc load)
+    {
+        multiDrawElementsIndirect = nullptr;
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        if (major > 4 || (major == 4 && minor >= 3) || hasExtension("GL_ARB_multi_draw_indirect"))
+            multiDrawElementsIndirect = (MultiDrawElementsIndirectProc)load("glMultiDrawElementsIndirect");
+        indirectAvailable = multiDrawElementsIndirect != nullptr;
+    }
+
+    unsigned int streams = 0; // VertexStreamMask every mesh in it has
+    size_t bytesPerVertex = 0;
+    unsigned int VAO = 0;     // 0 until the first add() or reserve()
+    int growths = 0;          // times the buffers were replaced
+
+    explicit GeometryArena(unsigned int streamMask = STREAMS_SHELL)
+    {
+        if (streamMask & STREAMS_SHELL_QUANTIZED) {
+            std::cout << "ERROR::GEOMETRY_ARENA::QUANTIZED_STREAM using the shell stream" << std::endl;
+            streamMask = (streamMask & ~(unsigned int)STREAMS_SHELL_QUANTIZED) | STREAMS_SHELL;
+        }
+        streams = streamMask;
+        for (int stream = 0; stream < VERTEX_STREAM_COUNT; stream++)
+            if (streams & (1u << stream))
+                bytesPerVertex += vertexStreamLayout((VertexStream)stream).stride;
+    }
+
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator=(const GeometryArena&) = delete;
+
+    ~GeometryArena()
+    {
+        destroy();
+    }
+
+    // room for this many more vertices and indices without growing, so a
+    // model that knows its totals up front is uploaded into buffers of the
+    // right size
+    void reserve(size_t vertices, size_t indices)
+    {
+        create();
+        size_t vertexCapacity = vertexRanges.used + vertices;
+        size_t indexCapacity = indexRanges.used + indices;
+        if (vertexCapacity > vertexRanges.capacity || indexCapacity > indexRanges.capacity)
+            resize(std::max(vertexCapacity, vertexRanges.capacity), std::max(indexCapacity, indexRanges.capacity));
+    }
+
+    Allocation add(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+    {
+        create();
+        Allocation allocation;
+        allocation.vertexCount = vertices.size();
+        allocation.indexCount = indices.size();
+        if (!vertexRanges.allocate(vertices.size(), allocation.firstVertex)) {
+            resize(std::max(vertexRanges.capacity * 2, vertexRanges.capacity + vertices.size()), indexRanges.capacity);
+            vertexRanges.allocate(vertices.size(), allocation.firstVertex);
+        }
+        if (!indexRanges.allocate(indices.size(), allocation.firstIndex)) {
+            resize(vertexRanges.capacity, std::max(indexRanges.capacity * 2, indexRanges.capacity + indices.size()));
+            indexRanges.allocate(indices.size(), allocation.firstIndex);
+        }
+
+        std::vector<unsigned char> packed;
+        for (int stream = 0; stream < VERTEX_STREAM_COUNT; stream++) {
+            if (!buffers[stream] || vertices.empty())
+                continue;
+            GLsizei stride = vertexStreamLayout((VertexStream)stream).stride;
+            packVertexStream((VertexStream)stream, vertices, packed);
+            glBindBuffer(GL_ARRAY_BUFFER, buffers[stream]);
+            glBufferSubData(GL_ARRAY_BUFFER, allocation.firstVertex * stride, packed.size(), packed.data());
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        if (!indices.empty()) {
+            // the element binding is VAO state, so it goes through the VAO
+            glBindVertexArray(VAO);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, allocation.firstIndex * sizeof(unsigned int),
+                            indices.size() * sizeof(unsigned int), indices.data());
+            glBindVertexArray(0);
+        }
+        return allocation;
+    }
+
+    // the space is reused by later adds, the buffers never shrink
+    void remove(const Allocation& allocation)
+    {
+        vertexRanges.release(allocation.firstVertex, allocation.vertexCount);
+        indexRanges.release(allocation.firstIndex, allocation.indexCount);
+    }
+
+    // one allocation, with the VAO bound
+    void draw(const Allocation& allocation, GLsizei instances = 1) const
+    {
+        const void* offset = (const void*)(allocation.firstIndex * sizeof(unsigned int));
+        if (instances == 1)
+            glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)allocation.indexCount, GL_UNSIGNED_INT, offset,
+                                     (GLint)allocation.firstVertex);
+        else
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, (GLsizei)allocation.indexCount, GL_UNSIGNED_INT, offset,
+                                              instances, (GLint)allocation.firstVertex);
+    }
+
+    // several allocations in one submission, with the VAO bound
+    void drawMulti(const std::vector<const Allocation*>& allocations, GLsizei instances = 1)
+    {
+        if (allocations.empty())
+            return;
+        if (instances == 1) {
+            counts.clear();
+            offsets.clear();
+            baseVertices.clear();
+            for (const Allocation* allocation : allocations) {
+                counts.push_back((GLsizei)allocation->indexCount);
+                offsets.push_back((const void*)(allocation->firstIndex * sizeof(unsigned int)));
+                baseVertices.push_back((GLint)allocation->firstVertex);
+            }
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts.data(), GL_UNSIGNED_INT, offsets.data(),
+                                          (GLsizei)allocations.size(), baseVertices.data());
+            return;
+        }
+        if (!indirectAvailable) {
+            for (const Allocation* allocation : allocations)
+                draw(*allocation, instances);
+            return;
+        }
+        commands.clear();
+        for (const Allocation* allocation : allocations)
+            commands.push_back({ (GLuint)allocation->indexCount, (GLuint)instances, (GLuint)allocation->firstIndex,
+                                 (GLint)allocation->firstVertex, 0 });
+        if (!indirectBuffer)
+            glGenBuffers(1, &indirectBuffer);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawCommand), commands.data(), GL_STREAM_DRAW);
+        multiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, (GLsizei)commands.size(), 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    // video memory of the buffers, allocated or not
+    size_t bytes() const
+    {
+        return vertexRanges.capacity * bytesPerVertex + indexRanges.capacity * sizeof(unsigned int);
+    }
+    // of which allocations use
+    size_t usedBytes() const
+    {
+        return vertexRanges.used * bytesPerVertex + indexRanges.used * sizeof(unsigned int);
+    }
+    size_t freeRanges() const { return vertexRanges.freeRanges() + indexRanges.freeRanges(); }
+
+    void report(const std::string& name) const
+    {
+        const double MB = 1024.0 * 1024.0;
+        std::cout << "Geometry arena: " << name << " " << vertexRanges.used << "/" << vertexRanges.capacity
+                  << " vertices, " << indexRanges.used << "/" << indexRanges.capacity << " indices, "
+                  << usedBytes() / MB << " of " << bytes() / MB << " MB used, grew " << growths << " times"
+                  << std::endl;
+    }
+
+    void destroy()
+    {
+        if (!VAO)
+            return;
+        glDeleteVertexArrays(1, &VAO);
+        for (unsigned int& buffer : buffers) {
+            if (buffer)
+                glDeleteBuffers(1, &buffer);
+            buffer = 0;
+        }
+        glDeleteBuffers(1, &EBO);
+        if (indirectBuffer)
+            glDeleteBuffers(1, &indirectBuffer);
+        VAO = EBO = indirectBuffer = 0;
+    }
+
+private:
+    // the command layout glMultiDrawElementsIndirect reads
+    struct DrawCommand {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+    typedef void (APIENTRYP MultiDrawElementsIndirectProc)(GLenum, GLenum, const void*, GLsizei, GLsizei);
+    static inline MultiDrawElementsIndirectProc multiDrawElementsIndirect = nullptr;
+
+    // first buffers, before anything says how big they have to be
+    static constexpr size_t INITIAL_VERTICES = 4096;
+    static constexpr size_t INITIAL_INDICES = 3 * INITIAL_VERTICES;
+
+    unsigned int buffers[VERTEX_STREAM_COUNT] = {};
+    unsigned int EBO = 0;
+    unsigned int indirectBuffer = 0;
+    ArenaRanges vertexRanges, indexRanges;
+    // drawMulti's arrays, kept so a draw doesn't allocate
+    std::vector<GLsizei> counts;
+    std::vector<const void*> offsets;
+    std::vector<GLint> baseVertices;
+    std::vector<DrawCommand> commands;
+
+    void create()
+    {
+        if (VAO)
+            return;
+        glGenVertexArrays(1, &VAO);
+        resize(INITIAL_VERTICES, INITIAL_INDICES);
+    }
+
+    // new buffers of the given capacity with the old contents copied to the
+    // same offsets, and the VAO pointed at them
+    void resize(size_t vertexCapacity, size_t indexCapacity)
+    {
+        bool grown = vertexRanges.capacity > 0;
+        glBindVertexArray(VAO);
+        for (int stream = 0; stream < VERTEX_STREAM_COUNT; stream++) {
+            if (!(streams & (1u << stream)))
+                continue;
+            const VertexStreamLayout& layout = vertexStreamLayout((VertexStream)stream);
+            buffers[stream] = resizeBuffer(buffers[stream], vertexRanges.capacity * layout.stride,
+                                           vertexCapacity * layout.stride);
+            glBindBuffer(GL_ARRAY_BUFFER, buffers[stream]);
+            applyVertexStreamLayout(layout);
+        }
+        EBO = resizeBuffer(EBO, indexRanges.capacity * sizeof(unsigned int), indexCapacity * sizeof(unsigned int));
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        vertexRanges.grow(vertexCapacity);
+        indexRanges.grow(indexCapacity);
+        if (grown)
+            growths++;
+    }
+
+    // through the copy bindings, so neither the VAO nor GL_ARRAY_BUFFER changes
+    static unsigned int resizeBuffer(unsigned int buffer, size_t oldBytes, size_t newBytes)
+    {
+        if (buffer && oldBytes >= newBytes)
+            return buffer;
+        unsigned int resized = 0;
+        glGenBuffers(1, &resized);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, resized);
+        glBufferData(GL_COPY_WRITE_BUFFER, newBytes, nullptr, GL_STATIC_DRAW);
+        if (buffer) {
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+            if (oldBytes > 0)
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldBytes);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            glDeleteBuffers(1, &buffer);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        return resized;
+    }
+
+    static bool hasExtension(const char* name)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++) {
+            const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+            if (extension && std::strcmp(extension, name) == 0)
+                return true;
+        }
+        return false;
+    }
+};
+#endif
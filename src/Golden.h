@@ -0,0 +1,152 @@
+#ifndef GOLDEN_H
+#define GOLDEN_H
+
+#include <glm/glm.hpp>
+
+#include "Image.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// A fixed view of the fur that rendering changes are checked against
+struct GoldenScene {
+    std::string name;
+    glm::vec3 cameraPos;
+    glm::vec3 cameraTarget;
+    float time;           // drives the ambient wind
+    int numLayers;
+    float gridFreq;
+    float strandThickness;
+    float furLength;
+};
+
+// the README presets plus a close-up and a grazing angle for the silhouette
+inline std::vector<GoldenScene> goldenScenes()
+{
+    return {
+        { "default",     { 0.0f, 0.0f, 3.0f },  { 0.0f, 0.0f, 0.0f }, 1.0f, 80, 1500.0f, 0.9f,  0.15f },
+        { "peach_fuzz",  { 0.0f, 0.0f, 3.0f },  { 0.0f, 0.0f, 0.0f }, 1.0f, 32, 1500.0f, 0.65f, 0.08f },
+        { "medium_fur",  { 0.0f, 0.0f, 3.0f },  { 0.0f, 0.0f, 0.0f }, 1.0f, 64, 1400.0f, 0.85f, 0.15f },
+        { "long_hair",   { 0.0f, 0.0f, 3.0f },  { 0.0f, 0.0f, 0.0f }, 2.5f, 80, 800.0f,  0.6f,  0.25f },
+        { "close_up",    { 0.4f, 0.3f, 1.6f },  { 0.0f, 0.0f, 0.0f }, 1.0f, 80, 1500.0f, 0.9f,  0.15f },
+        { "silhouette",  { 2.6f, 1.4f, 0.4f },  { 0.0f, 0.0f, 0.0f }, 1.0f, 80, 1500.0f, 0.9f,  0.15f },
+    };
+}
+
+// Result of comparing a render against its golden image
+struct ImageDiff {
+    bool sizeMismatch = false;
+    double meanDeltaE = 0.0;
+    double maxDeltaE = 0.0;
+    double failedPct = 0.0;  // pixels above the per-pixel threshold
+    double psnr = 0.0;       // on RGB, infinite when identical
+};
+
+// Perceptual comparison: colors are compared as CIE76 delta E in L*a*b*,
+// where ~2.3 is a just noticeable difference. A render passes when no more
+// than maxFailedPct of its pixels differ by more than deltaEThreshold, so a
+// handful of strands landing a pixel over (driver rounding) doesn't fail.
+class GoldenCompare {
+public:
+    double deltaEThreshold = 10.0;
+    double maxFailedPct = 0.5;
+
+    // both images RGBA8, rows bottom first as glReadPixels returns them.
+    // diff gets a visualization: the golden in gray, failing pixels in red
+    ImageDiff compare(const std::vector<unsigned char>& actual, const std::vector<unsigned char>& golden,
+                      int width, int height, std::vector<unsigned char>& diff) const
+    {
+        ImageDiff result;
+        size_t pixels = (size_t)width * height;
+        if (actual.size() != pixels * 4 || golden.size() != pixels * 4) {
+            result.sizeMismatch = true;
+            result.failedPct = 100.0;
+            return result;
+        }
+        diff.resize(pixels * 4);
+
+        double sumDeltaE = 0.0, sumSq = 0.0;
+        size_t failed = 0;
+        for (size_t i = 0; i < pixels; i++) {
+            const unsigned char* a = &actual[i * 4];
+            const unsigned char* g = &golden[i * 4];
+            glm::vec3 labA = toLab(a), labG = toLab(g);
+            double dE = glm::length(labA - labG);
+            sumDeltaE += dE;
+            result.maxDeltaE = std::max(result.maxDeltaE, dE);
+            for (int c = 0; c < 3; c++)
+                sumSq += (double)(a[c] - g[c]) * (a[c] - g[c]);
+
+            unsigned char gray = (unsigned char)(labG.x * 2.55f * 0.4f);
+            unsigned char* d = &diff[i * 4];
+            if (dE > deltaEThreshold) {
+                failed++;
+                d[0] = 255;
+                d[1] = d[2] = (unsigned char)std::max(0.0, 160.0 - dE * 4.0);
+            } else {
+                d[0] = d[1] = d[2] = gray;
+            }
+            d[3] = 255;
+        }
+        result.meanDeltaE = sumDeltaE / pixels;
+        result.failedPct = 100.0 * failed / pixels;
+        double mse = sumSq / (pixels * 3.0);
+        result.psnr = mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : INFINITY;
+        return result;
+    }
+
+    bool passed(const ImageDiff& diff) const
+    {
+        return !diff.sizeMismatch && diff.failedPct <= maxFailedPct;
+    }
+
+    // loads a golden written by writePNG, rows bottom first like glReadPixels.
+    // like Model.h this expects stb_image.h to be included before this header
+    static bool load(const std::string& path, int width, int height, std::vector<unsigned char>& rgba)
+    {
+        stbi_set_flip_vertically_on_load(true);
+        int w, h, n;
+        unsigned char* data = stbi_load(path.c_str(), &w, &h, &n, 4);
+        if (!data) {
+            std::cout << "ERROR::GOLDEN::COULD_NOT_LOAD " << path << std::endl;
+            return false;
+        }
+        bool matches = w == width && h == height;
+        if (matches)
+            rgba.assign(data, data + (size_t)w * h * 4);
+        else
+            std::cout << "ERROR::GOLDEN::SIZE_MISMATCH " << path << " is " << w << "x" << h
+                      << ", rendered " << width << "x" << height << std::endl;
+        stbi_image_free(data);
+        return matches;
+    }
+
+private:
+    // sRGB (D65) to CIE L*a*b*
+    static glm::vec3 toLab(const unsigned char* rgb)
+    {
+        static float linear[256];
+        static bool tableReady = false;
+        if (!tableReady) {
+            for (int i = 0; i < 256; i++) {
+                float c = i / 255.0f;
+                linear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            tableReady = true;
+        }
+        float r = linear[rgb[0]], g = linear[rgb[1]], b = linear[rgb[2]];
+        glm::vec3 xyz(0.4124f * r + 0.3576f * g + 0.1805f * b,
+                      0.2126f * r + 0.7152f * g + 0.0722f * b,
+                      0.0193f * r + 0.1192f * g + 0.9505f * b);
+        xyz /= glm::vec3(0.95047f, 1.0f, 1.08883f);
+        auto f = [](float t) {
+            return t > 0.008856f ? std::cbrt(t) : 7.787f * t + 16.0f / 116.0f;
+        };
+        glm::vec3 fxyz(f(xyz.x), f(xyz.y), f(xyz.z));
+        return glm::vec3(116.0f * fxyz.y - 16.0f, 500.0f * (fxyz.x - fxyz.y), 200.0f * (fxyz.y - fxyz.z));
+    }
+};
+#endif
@@ -0,0 +1,168 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <glad/glad.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+// GPU time of one frame, split up by pass
+struct GpuFrameTiming {
+    int frame = -1;              // frame index passed to beginFrame
+    double totalMs = 0.0;        // first to last GPU command of the frame
+    std::vector<double> passMs;  // 0 for passes that did not run
+};
+
+// Per-pass GPU timing with GL_TIMESTAMP queries.
+// Queries live in a ring of RING_SIZE frames and are only read once the
+// driver reports them available, several frames after they were issued,
+// so measuring never stalls the pipeline. If the GPU falls further behind
+// than the ring, the oldest frame is dropped rather than waited on.
+class GpuTimer {
+public:
+    static const int RING_SIZE = 5;
+
+    std::vector<std::string> passNames;
+    int droppedFrames = 0;
+
+    GpuTimer() = default;
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    ~GpuTimer()
+    {
+        for (Slot& slot : slots)
+            if (!slot.queries.empty())
+                glDeleteQueries((GLsizei)slot.queries.size(), slot.queries.data());
+    }
+
+    // creates the query ring, pass ids are indices into passNames
+    void init(const std::vector<std::string>& names)
+    {
+        passNames = names;
+        // frame begin/end + begin/end per pass
+        size_t queryCount = 2 + 2 * passNames.size();
+        for (Slot& slot : slots) {
+            slot.queries.resize(queryCount);
+            glGenQueries((GLsizei)queryCount, slot.queries.data());
+            slot.passUsed.assign(passNames.size(), false);
+        }
+        latestTiming.passMs.assign(passNames.size(), 0.0);
+    }
+
+    void beginFrame(int frameIndex)
+    {
+        collect(false);
+
+        current = &slots[submitted % RING_SIZE];
+        if (current->pending) {
+            // still not available after RING_SIZE frames, give up on it.
+            // it is always the oldest uncollected frame
+            current->pending = false;
+            collected++;
+            droppedFrames++;
+        }
+        current->frame = frameIndex;
+        current->passUsed.assign(passNames.size(), false);
+        glQueryCounter(current->queries[0], GL_TIMESTAMP);
+    }
+
+    void beginPass(int pass)
+    {
+        current->passUsed[pass] = true;
+        glQueryCounter(current->queries[2 + 2 * pass], GL_TIMESTAMP);
+    }
+
+    void endPass(int pass)
+    {
+        glQueryCounter(current->queries[3 + 2 * pass], GL_TIMESTAMP);
+    }
+
+    void endFrame()
+    {
+        glQueryCounter(current->queries[1], GL_TIMESTAMP);
+        current->pending = true;
+        current = nullptr;
+        submitted++;
+    }
+
+    // reads every finished frame in submission order. wait = true blocks
+    // until all outstanding frames are done (only meant for shutdown)
+    void collect(bool wait)
+    {
+        while (collected < submitted) {
+            Slot& slot = slots[collected % RING_SIZE];
+            if (!slot.pending) { // dropped
+                collected++;
+                continue;
+            }
+            if (!wait) {
+                GLint available = 0;
+                glGetQueryObjectiv(slot.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available)
+                    return; // later frames can't be done either
+            }
+
+            GpuFrameTiming timing;
+            timing.frame = slot.frame;
+            timing.totalMs = elapsedMs(slot.queries[0], slot.queries[1]);
+            timing.passMs.assign(passNames.size(), 0.0);
+            for (size_t pass = 0; pass < passNames.size(); pass++)
+                if (slot.passUsed[pass])
+                    timing.passMs[pass] = elapsedMs(slot.queries[2 + 2 * pass], slot.queries[3 + 2 * pass]);
+
+            slot.pending = false;
+            collected++;
+
+            latestTiming = timing;
+            resolved.push_back(timing);
+            if (resolved.size() > MAX_RESOLVED)
+                resolved.pop_front();
+        }
+    }
+
+    // most recent frame that finished on the GPU, for the HUD
+    const GpuFrameTiming& latest() const
+    {
+        return latestTiming;
+    }
+
+    // hands out finished frames oldest first, for consumers that need
+    // every frame (benchmark output)
+    bool popResolved(GpuFrameTiming& timing)
+    {
+        if (resolved.empty())
+            return false;
+        timing = resolved.front();
+        resolved.pop_front();
+        return true;
+    }
+
+private:
+    // unconsumed frames kept for popResolved
+    static const size_t MAX_RESOLVED = 1024;
+
+    struct Slot {
+        std::vector<unsigned int> queries;
+        std::vector<bool> passUsed;
+        int frame = -1;
+        bool pending = false;
+    };
+
+    Slot slots[RING_SIZE];
+    Slot* current = nullptr;
+    long long submitted = 0;
+    long long collected = 0;
+    GpuFrameTiming latestTiming;
+    std::deque<GpuFrameTiming> resolved;
+
+    static double elapsedMs(unsigned int beginQuery, unsigned int endQuery)
+    {
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(beginQuery, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(endQuery, GL_QUERY_RESULT, &end);
+        return end > begin ? (end - begin) / 1.0e6 : 0.0;
+    }
+};
+#endif
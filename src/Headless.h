@@ -0,0 +1,203 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <glad/glad.h>
+
+#ifdef SHELL_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Window-less OpenGL context for render nodes and CI machines without a GPU.
+// Uses a surfaceless EGL display (Mesa llvmpipe works), so nothing is ever
+// presented; all rendering goes into a RenderTarget instead.
+class HeadlessContext {
+public:
+    HeadlessContext() = default;
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+    ~HeadlessContext()
+    {
+#ifdef SHELL_HAS_EGL
+        if (display != EGL_NO_DISPLAY) {
+            eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            if (context != EGL_NO_CONTEXT)
+                eglDestroyContext(display, context);
+            eglTerminate(display);
+        }
+#endif
+    }
+
+    // creates a 3.3 core context and makes it current, returns false on failure
+    bool init()
+    {
+#ifdef SHELL_HAS_EGL
+        // prefer the surfaceless platform so no X/Wayland/DRM device is needed
+        auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+            eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay)
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (display == EGL_NO_DISPLAY)
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+        EGLint major, minor;
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+            std::cout << "ERROR::HEADLESS::EGL_INITIALIZE_FAILED" << std::endl;
+            return false;
+        }
+        if (!eglBindAPI(EGL_OPENGL_API)) {
+            std::cout << "ERROR::HEADLESS::EGL_NO_DESKTOP_GL" << std::endl;
+            return false;
+        }
+
+        // configless contexts are what surfaceless Mesa hands out, fall back
+        // to picking a pbuffer capable config for other drivers
+        EGLConfig config = EGL_NO_CONFIG_KHR;
+        const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+        bool configless = extensions && (strstr(extensions, "EGL_KHR_no_config_context") ||
+                                         strstr(extensions, "EGL_MESA_configless_context"));
+        if (!configless) {
+            const EGLint configAttribs[] = {
+                EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                EGL_NONE
+            };
+            EGLint numConfigs = 0;
+            if (!eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) || numConfigs == 0) {
+                std::cout << "ERROR::HEADLESS::EGL_NO_CONFIG" << std::endl;
+                return false;
+            }
+        }
+
+        const EGLint contextAttribs[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 3,
+            EGL_CONTEXT_MINOR_VERSION, 3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+        if (context == EGL_NO_CONTEXT) {
+            std::cout << "ERROR::HEADLESS::EGL_CREATE_CONTEXT_FAILED 0x" << std::hex
+                      << eglGetError() << std::dec << std::endl;
+            return false;
+        }
+        if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+            std::cout << "ERROR::HEADLESS::EGL_MAKE_CURRENT_FAILED" << std::endl;
+            return false;
+        }
+        return true;
+#else
+        std::cout << "ERROR::HEADLESS::BUILT_WITHOUT_EGL" << std::endl;
+        return false;
+#endif
+    }
+
+    // matches the GLADloadproc signature
+    static void* getProcAddress(const char* name)
+    {
+#ifdef SHELL_HAS_EGL
+        return (void*)eglGetProcAddress(name);
+#else
+        (void)name;
+        return nullptr;
+#endif
+    }
+
+private:
+#ifdef SHELL_HAS_EGL
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+#endif
+};
+
+// Offscreen framebuffer with a color and a depth attachment. Stands in for
+// the window's default framebuffer in headless mode, and with a sampled
+// color attachment it doubles as an intermediate target for diagnostics
+class RenderTarget {
+public:
+    unsigned int FBO = 0;
+    unsigned int colorTexture = 0; // only set when created with sampled = true
+    int width = 0;
+    int height = 0;
+
+    RenderTarget() = default;
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget& operator=(const RenderTarget&) = delete;
+
+    ~RenderTarget()
+    {
+        release();
+    }
+
+    bool create(int w, int h, GLenum colorFormat = GL_RGBA8, bool sampled = false)
+    {
+        release();
+        width = w;
+        height = h;
+
+        glGenFramebuffers(1, &FBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+
+        if (sampled) {
+            glGenTextures(1, &colorTexture);
+            glBindTexture(GL_TEXTURE_2D, colorTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, colorFormat, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+        } else {
+            glGenRenderbuffers(1, &colorRBO);
+            glBindRenderbuffer(GL_RENDERBUFFER, colorRBO);
+            glRenderbufferStorage(GL_RENDERBUFFER, colorFormat, width, height);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRBO);
+        }
+
+        glGenRenderbuffers(1, &depthRBO);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthRBO);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthRBO);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        if (!complete)
+            std::cout << "ERROR::FRAMEBUFFER::NOT_COMPLETE" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return complete;
+    }
+
+    void bind() const
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glViewport(0, 0, width, height);
+    }
+
+    // reads back the color attachment (bottom row first)
+    void readPixels(std::vector<unsigned char>& rgba) const
+    {
+        rgba.resize((size_t)width * height * 4);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+    }
+
+private:
+    unsigned int colorRBO = 0, depthRBO = 0;
+
+    void release()
+    {
+        if (FBO) glDeleteFramebuffers(1, &FBO);
+        if (colorTexture) glDeleteTextures(1, &colorTexture);
+        if (colorRBO) glDeleteRenderbuffers(1, &colorRBO);
+        if (depthRBO) glDeleteRenderbuffers(1, &depthRBO);
+        FBO = colorTexture = colorRBO = depthRBO = 0;
+    }
+};
+#endif
@@ -0,0 +1,115 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Minimal PNG writer so headless runs can dump frames without pulling in
+// another dependency. Pixel data is stored uncompressed (deflate "stored"
+// blocks), which keeps the encoder tiny at the cost of larger files.
+
+inline uint32_t pngCrc32(const unsigned char* data, size_t len, uint32_t crc = 0xFFFFFFFFu)
+{
+    static uint32_t table[256];
+    static bool tableReady = false;
+    if (!tableReady) {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+        tableReady = true;
+    }
+    for (size_t i = 0; i < len; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+inline void pngPutU32(std::vector<unsigned char>& out, uint32_t v)
+{
+    out.push_back((v >> 24) & 0xFF);
+    out.push_back((v >> 16) & 0xFF);
+    out.push_back((v >> 8) & 0xFF);
+    out.push_back(v & 0xFF);
+}
+
+inline void pngWriteChunk(std::ofstream& file, const char* type, const std::vector<unsigned char>& data)
+{
+    std::vector<unsigned char> chunk;
+    pngPutU32(chunk, (uint32_t)data.size());
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    // crc covers the type and the data, not the length
+    uint32_t crc = pngCrc32(chunk.data() + 4, chunk.size() - 4) ^ 0xFFFFFFFFu;
+    pngPutU32(chunk, crc);
+    file.write((const char*)chunk.data(), chunk.size());
+}
+
+// writes 8-bit RGBA pixels to a PNG file.
+// flipY is used for glReadPixels output, which starts at the bottom row
+inline bool writePNG(const std::string& path, int width, int height,
+                     const unsigned char* rgba, bool flipY = true)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cout << "ERROR::IMAGE::COULD_NOT_OPEN " << path << std::endl;
+        return false;
+    }
+    const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    file.write((const char*)signature, 8);
+
+    std::vector<unsigned char> header;
+    pngPutU32(header, (uint32_t)width);
+    pngPutU32(header, (uint32_t)height);
+    header.push_back(8); // bit depth
+    header.push_back(6); // color type RGBA
+    header.push_back(0); // compression
+    header.push_back(0); // filter
+    header.push_back(0); // no interlace
+    pngWriteChunk(file, "IHDR", header);
+
+    // raw scanlines, each prefixed with filter type 0 (none)
+    size_t rowBytes = (size_t)width * 4;
+    std::vector<unsigned char> raw;
+    raw.reserve((rowBytes + 1) * height);
+    for (int y = 0; y < height; y++) {
+        int srcRow = flipY ? (height - 1 - y) : y;
+        raw.push_back(0);
+        const unsigned char* row = rgba + srcRow * rowBytes;
+        raw.insert(raw.end(), row, row + rowBytes);
+    }
+
+    // zlib stream made of stored blocks (max 65535 bytes each)
+    std::vector<unsigned char> zlib;
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+    size_t pos = 0;
+    do {
+        size_t blockLen = std::min<size_t>(65535, raw.size() - pos);
+        bool last = (pos + blockLen == raw.size());
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(blockLen & 0xFF);
+        zlib.push_back((blockLen >> 8) & 0xFF);
+        zlib.push_back(~blockLen & 0xFF);
+        zlib.push_back((~blockLen >> 8) & 0xFF);
+        zlib.insert(zlib.end(), raw.begin() + pos, raw.begin() + pos + blockLen);
+        pos += blockLen;
+    } while (pos < raw.size());
+
+    uint32_t a = 1, b = 0; // adler32 of the uncompressed data
+    for (unsigned char c : raw) {
+        a = (a + c) % 65521;
+        b = (b + a) % 65521;
+    }
+    pngPutU32(zlib, (b << 16) | a);
+    pngWriteChunk(file, "IDAT", zlib);
+    pngWriteChunk(file, "IEND", {});
+
+    return (bool)file;
+}
+#endif
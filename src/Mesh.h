@@ -5,57 +5,164 @@
 #include <glm/glm.hpp>
 
 #include "Shader.h"
+#include "VertexLayout.h"
+#include "MeshOptimizer.h"
+#include "MeshResidency.h"
+#include "GeometryArena.h"
 
 #include <string>
+#include <utility>
 #include <vector>
 
-#define MAX_BONE_INFLUENCE 4
-
-struct Vertex {
-    glm::vec3 Position;     // position
-    glm::vec3 Normal;       // normal
-    glm::vec2 TexCoords;    // texCoords
-    glm::vec3 Tangent;      // tangent
-    glm::vec3 Bitangent;    // bitangent
-        // bone indexes which will influence this vertex
-        int m_BoneIDs[MAX_BONE_INFLUENCE];
-        // weights for each bone
-        float m_Weights[MAX_BONE_INFLUENCE];
-};
-
 struct Texture {
     unsigned int id;
     std::string type;
     std::string path;
 };
 
+// Owns its GL buffers and deletes them when destroyed, so it can be moved
+// but not copied: a copy would share the handles and delete them twice.
+// Hand the vectors over with std::move, they are taken over rather than copied.
+// After the upload the CPU data is kept as residency says, so vertices and
+// indices may be empty: read geometry through position()/normal() instead.
+// Built into a GeometryArena it owns an allocation there instead of buffers
+// of its own, and frees it when destroyed, so the arena has to outlive it
 class Mesh {
 public:
-/* Right now Mesh is copyable by default (because it contains GLuints). 
-If I ever do meshes.push_back(mesh) by value, I can get double-deletes later.
-Two common solutions:
-store meshes with move semantics and delete copy, or
-store them as std::unique_ptr<Mesh> */
-
     // Mesh Data
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
-    std::vector<Texture> textures;
-    unsigned int VAO;
+    std::vector<Vertex> vertices;      // RESIDENCY_FULL only
+    std::vector<unsigned int> indices; // RESIDENCY_FULL and RESIDENCY_QUANTIZED
+    std::vector<Texture> textures; // not owned, Model shares them between meshes
+    unsigned int VAO = 0;
+    MeshResidency residency = RESIDENCY_FULL;
+    QuantizedVertexCopy quantized; // RESIDENCY_QUANTIZED only
+
+    // constructor, streams are the VertexStreamMask the drawing pipeline reads
+    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures,
+         unsigned int streams = STREAMS_SHELL, MeshResidency residency = RESIDENCY_FULL)
+        : vertices(std::move(vertices)), indices(std::move(indices)), textures(std::move(textures)),
+          residency(residency)
+    {
+        // every shell layer draws the mesh again, so order it for the caches
+        MeshOptimizer::optimize(this->vertices, this->indices);
+        // now with all data, set up vertex buffer and attribute pointers
+        setUpMesh(streams);
+        applyMeshResidency(residency, this->vertices, this->indices, quantized);
+    }
 
-    // constructor
-    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indicies, std::vector<Texture> textures)
+    // the same, uploaded into arena with arena.streams
+    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures,
+         GeometryArena& arena, MeshResidency residency = RESIDENCY_FULL)
+        : vertices(std::move(vertices)), indices(std::move(indices)), textures(std::move(textures)),
+          residency(residency), arena(&arena)
     {
-        this->vertices = vertices;
-        this->indices = indicies;
-        this->textures = textures;
+        MeshOptimizer::optimize(this->vertices, this->indices);
+        allocation = arena.add(this->vertices, this->indices);
+        VAO = arena.VAO;
+        applyMeshResidency(residency, this->vertices, this->indices, quantized);
+    }
 
-        // now with all data, set up vertex buffer and attribute pointers
-        setUpMesh();
+    // geometry that survived the residency policy, not for RESIDENCY_DISCARD
+    size_t vertexCount() const { return arena ? allocation.vertexCount : buffers.vertexCount; }
+    glm::vec3 position(size_t i) const
+    {
+        return residency == RESIDENCY_QUANTIZED ? quantized.position(i) : vertices[i].Position;
+    }
+    glm::vec3 normal(size_t i) const
+    {
+        return residency == RESIDENCY_QUANTIZED ? quantized.normal(i) : vertices[i].Normal;
+    }
+
+    MeshMemory memory() const
+    {
+        if (arena)
+            return MeshMemory::of(vertices, indices, quantized, allocation.vertexCount, allocation.indexCount,
+                                  allocation.vertexCount * arena->bytesPerVertex +
+                                      allocation.indexCount * sizeof(unsigned int));
+        return MeshMemory::of(vertices, indices, quantized, buffers);
+    }
+
+    // null for a mesh with its own buffers
+    GeometryArena* geometryArena() const { return arena; }
+    const GeometryArena::Allocation& arenaAllocation() const { return allocation; }
+
+    // whether both bind the same textures, so they can be drawn together
+    bool sameTextures(const Mesh& other) const
+    {
+        if (textures.size() != other.textures.size())
+            return false;
+        for (size_t i = 0; i < textures.size(); i++)
+            if (textures[i].id != other.textures[i].id || textures[i].type != other.textures[i].type)
+                return false;
+        return true;
+    }
+
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+
+    Mesh(Mesh&& other) noexcept
+        : vertices(std::move(other.vertices)), indices(std::move(other.indices)),
+          textures(std::move(other.textures)), VAO(other.VAO), residency(other.residency),
+          quantized(std::move(other.quantized)), arena(other.arena), allocation(other.allocation),
+          buffers(other.buffers)
+    {
+        other.VAO = 0;
+        other.arena = nullptr;
+        other.buffers = VertexBuffers();
+    }
+
+    Mesh& operator=(Mesh&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            vertices = std::move(other.vertices);
+            indices = std::move(other.indices);
+            textures = std::move(other.textures);
+            VAO = other.VAO;
+            residency = other.residency;
+            quantized = std::move(other.quantized);
+            arena = other.arena;
+            allocation = other.allocation;
+            buffers = other.buffers;
+            other.VAO = 0;
+            other.arena = nullptr;
+            other.buffers = VertexBuffers();
+        }
+        return *this;
     }
 
-    // render the mesh
-    void Draw(Shader &shader)
+    ~Mesh()
+    {
+        release();
+    }
+
+    // render the mesh, instances times with instances > 1. decode says how
+    // basic.vert decodes the vertices, resolved once per shader
+    void Draw(Shader &shader, const VertexDecodeUniforms &decode, GLsizei instances = 1)
+    {
+        bindTextures(shader);
+
+        if (arena)
+            shader.setBool(decode.quantized, false);
+        else
+            decode.set(shader, buffers);
+
+        // draw the mesh
+        glBindVertexArray(VAO);
+        if (arena)
+            arena->draw(allocation, instances);
+        else if (instances == 1)
+            glDrawElements(GL_TRIANGLES, buffers.indexCount, buffers.indexType, 0);
+        else
+            glDrawElementsInstanced(GL_TRIANGLES, buffers.indexCount, buffers.indexType, 0, instances);
+        glBindVertexArray(0); // unbind
+
+        // sets back to default
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // binds textures to units 0..n and points the samplers at them
+    void bindTextures(Shader &shader) const
     {
         // bind appropiate textures
         unsigned int diffuseNr = 1;
@@ -78,65 +185,33 @@ store them as std::unique_ptr<Mesh> */
                 number = std::to_string(heighNr++); // transfer unsigned int to string
             
             // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
+            shader.setInt(name + number, i);
             // finally bind texture
             glBindTexture(GL_TEXTURE_2D, textures[i].id);
         }
-
-        // draw the mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0); // unbind
-
-        // sets back to default
-        glActiveTexture(GL_TEXTURE0);
     }
 
 private:
-    // rendering data
-    unsigned int VBO, EBO;
+    // rendering data, one or the other
+    GeometryArena* arena = nullptr;
+    GeometryArena::Allocation allocation;
+    VertexBuffers buffers;
 
-    void setUpMesh()
+    void setUpMesh(unsigned int streams)
     {
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
+        buffers.upload(vertices, indices, streams);
+        VAO = buffers.VAO;
+    }
 
-        glBindVertexArray(VAO);
-        // load data into vertex buffers
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        // Can use address of vertices 0 since struct goes by sequential
-        // glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        // glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-        // set vertex attribute pointers
-        glEnableVertexAttribArray(0);
-        // vertex Position
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // vertex normals
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        // vertex texture coords
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-        // vertex tangent
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-        // vertex bitangent
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
-            // ids
-            glEnableVertexAttribArray(5);
-            glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
-            
-            // weights
-            glEnableVertexAttribArray(6);
-            glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
-        glBindVertexArray(0);
+    // a moved-from mesh has nothing left to delete
+    void release()
+    {
+        if (arena)
+            arena->remove(allocation);
+        arena = nullptr;
+        if (buffers.VAO)
+            buffers.destroy();
+        VAO = 0;
     }
 };
 #endif
\ No newline at end of file
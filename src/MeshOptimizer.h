@@ -0,0 +1,233 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <glm/glm.hpp>
+
+#include "Profiler.h"
+#include "VertexLayout.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Reorders a triangle list before upload so every shell layer, which draws
+// the whole mesh again, costs less:
+//  1. Tipsify (Sander, Nehab, Barczak 2007): triangle order for the post-
+//     transform vertex cache, fanning around recently used vertices
+//  2. the clusters it leaves between cache flushes are sorted outside-in
+//     (facing away from the mesh center first), so the opaque base layer
+//     tends to draw front surfaces before what they hide, from any side
+//  3. vertices renumbered in first use order, so fetches walk the vertex
+//     buffer forwards
+// Only the order changes, the triangles and their winding stay the same.
+struct MeshOptimizeStats {
+    size_t triangles = 0;
+    float acmrBefore = 0.0f; // vertex shader runs per triangle, FIFO cache
+    float acmrAfter = 0.0f;
+    int cacheSize = 0;
+
+    void report(const std::string& name) const
+    {
+        std::cout << "Mesh optimizer: " << name << " " << triangles << " triangles, ACMR "
+                  << acmrBefore << " -> " << acmrAfter << " (" << cacheSize << " entry FIFO)" << std::endl;
+    }
+};
+
+class MeshOptimizer {
+public:
+    // post-transform cache the ordering targets and the ACMR is measured with
+    static constexpr int CACHE_SIZE = 16;
+    // clusters longer than this are split, so the overdraw sort has something to work with
+    static constexpr size_t MAX_CLUSTER_TRIANGLES = 64;
+
+    static MeshOptimizeStats optimize(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+    {
+        PROFILE_SCOPE("MeshOptimizer::optimize");
+        MeshOptimizeStats stats;
+        stats.cacheSize = CACHE_SIZE;
+        stats.triangles = indices.size() / 3;
+        if (stats.triangles == 0 || vertices.empty())
+            return stats;
+        stats.acmrBefore = acmr(indices, vertices.size());
+
+        std::vector<size_t> clusters;
+        std::vector<unsigned int> ordered = tipsify(indices, vertices.size(), clusters);
+        indices = sortClusters(vertices, ordered, clusters);
+        reorderVertices(vertices, indices);
+
+        stats.acmrAfter = acmr(indices, vertices.size());
+        return stats;
+    }
+
+    // average cache miss ratio: vertices transformed per triangle, 0.5 is the
+    // best a regular grid can do, 3 means no reuse at all
+    static float acmr(const std::vector<unsigned int>& indices, size_t vertexCount, int cacheSize = CACHE_SIZE)
+    {
+        if (indices.size() < 3)
+            return 0.0f;
+        std::vector<size_t> insertedAt(vertexCount, 0); // FIFO position + 1, 0 = never
+        size_t misses = 0;
+        for (unsigned int index : indices) {
+            if (insertedAt[index] == 0 || misses - insertedAt[index] + 1 > (size_t)cacheSize) {
+                misses++;
+                insertedAt[index] = misses;
+            }
+        }
+        return (float)misses / (float)(indices.size() / 3);
+    }
+
+private:
+    // triangle order, and in clusters where each cluster starts (triangle offsets)
+    static std::vector<unsigned int> tipsify(const std::vector<unsigned int>& indices, size_t vertexCount,
+                                             std::vector<size_t>& clusters)
+    {
+        size_t triangleCount = indices.size() / 3;
+        // triangles around each vertex, as offsets into adjacency
+        std::vector<unsigned int> live(vertexCount, 0);
+        for (unsigned int index : indices)
+            live[index]++;
+        std::vector<size_t> firstTriangle(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; v++)
+            firstTriangle[v + 1] = firstTriangle[v] + live[v];
+        std::vector<unsigned int> adjacency(indices.size());
+        std::vector<size_t> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+        for (size_t t = 0; t < triangleCount; t++)
+            for (int c = 0; c < 3; c++)
+                adjacency[fill[indices[t * 3 + c]]++] = (unsigned int)t;
+
+        std::vector<int> cacheTime(vertexCount, 0);
+        std::vector<char> emitted(triangleCount, 0);
+        std::vector<unsigned int> deadEnds;
+        std::vector<unsigned int> candidates;
+        std::vector<unsigned int> out;
+        out.reserve(indices.size());
+        int time = CACHE_SIZE + 1;
+        size_t cursor = 0;
+        int fanning = 0;
+        clusters.assign(1, 0);
+        while (fanning >= 0) {
+            candidates.clear();
+            for (size_t a = firstTriangle[fanning]; a < firstTriangle[fanning + 1]; a++) {
+                unsigned int t = adjacency[a];
+                if (emitted[t])
+                    continue;
+                if (out.size() / 3 - clusters.back() >= MAX_CLUSTER_TRIANGLES)
+                    clusters.push_back(out.size() / 3);
+                for (int c = 0; c < 3; c++) {
+                    unsigned int v = indices[t * 3 + c];
+                    out.push_back(v);
+                    deadEnds.push_back(v);
+                    candidates.push_back(v);
+                    live[v]--;
+                    if (time - cacheTime[v] > CACHE_SIZE)
+                        cacheTime[v] = time++;
+                }
+                emitted[t] = 1;
+            }
+
+            // the candidate still in the cache with the most triangles left,
+            // as long as fanning around it doesn't push it out
+            fanning = -1;
+            int best = 0; // out of the cache window (priority 0) is a dead end
+            for (unsigned int v : candidates) {
+                if (live[v] == 0)
+                    continue;
+                int age = time - cacheTime[v];
+                int priority = age + 2 * (int)live[v] <= CACHE_SIZE ? age : 0;
+                if (priority > best) {
+                    best = priority;
+                    fanning = (int)v;
+                }
+            }
+            if (fanning >= 0)
+                continue;
+            // dead end: the most recent vertex with triangles left, else
+            // the next one in input order. A new cluster starts here
+            while (!deadEnds.empty() && fanning < 0) {
+                unsigned int v = deadEnds.back();
+                deadEnds.pop_back();
+                if (live[v] > 0)
+                    fanning = (int)v;
+            }
+            while (fanning < 0 && cursor < vertexCount) {
+                if (live[cursor] > 0)
+                    fanning = (int)cursor;
+                cursor++;
+            }
+            if (fanning >= 0 && out.size() / 3 > clusters.back())
+                clusters.push_back(out.size() / 3);
+        }
+        return out;
+    }
+
+    // outside-in: clusters whose normal points away from the mesh center come first
+    static std::vector<unsigned int> sortClusters(const std::vector<Vertex>& vertices,
+                                                  const std::vector<unsigned int>& indices,
+                                                  const std::vector<size_t>& clusters)
+    {
+        size_t triangleCount = indices.size() / 3;
+        glm::vec3 meshCenter(0.0f);
+        for (unsigned int index : indices)
+            meshCenter += vertices[index].Position;
+        meshCenter /= (float)indices.size();
+
+        struct Cluster {
+            size_t first, count;
+            float facing;
+        };
+        std::vector<Cluster> sorted;
+        for (size_t c = 0; c < clusters.size(); c++) {
+            size_t first = clusters[c];
+            size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+            // both area weighted
+            glm::vec3 center(0.0f), normal(0.0f);
+            float area = 0.0f;
+            for (size_t t = first; t < end; t++) {
+                const glm::vec3& a = vertices[indices[t * 3]].Position;
+                const glm::vec3& b = vertices[indices[t * 3 + 1]].Position;
+                const glm::vec3& d = vertices[indices[t * 3 + 2]].Position;
+                glm::vec3 cross = glm::cross(b - a, d - a);
+                float triangleArea = glm::length(cross);
+                normal += cross;
+                center += (a + b + d) * (triangleArea / 3.0f);
+                area += triangleArea;
+            }
+            center = area > 0.0f ? center / area : vertices[indices[first * 3]].Position;
+            float length = glm::length(normal);
+            float facing = length > 0.0f ? glm::dot(center - meshCenter, normal / length) : 0.0f;
+            sorted.push_back({ first, end - first, facing });
+        }
+        std::stable_sort(sorted.begin(), sorted.end(),
+                         [](const Cluster& a, const Cluster& b) { return a.facing > b.facing; });
+
+        std::vector<unsigned int> out;
+        out.reserve(indices.size());
+        for (const Cluster& cluster : sorted)
+            out.insert(out.end(), indices.begin() + cluster.first * 3,
+                       indices.begin() + (cluster.first + cluster.count) * 3);
+        return out;
+    }
+
+    // first use order, vertices no triangle uses go last
+    static void reorderVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+    {
+        const unsigned int unused = ~0u;
+        std::vector<unsigned int> remap(vertices.size(), unused);
+        std::vector<Vertex> reordered;
+        reordered.reserve(vertices.size());
+        for (unsigned int& index : indices) {
+            if (remap[index] == unused) {
+                remap[index] = (unsigned int)reordered.size();
+                reordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        for (size_t v = 0; v < vertices.size(); v++)
+            if (remap[v] == unused)
+                reordered.push_back(vertices[v]);
+        vertices.swap(reordered);
+    }
+};
+#endif
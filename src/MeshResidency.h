@@ -0,0 +1,113 @@
+#ifndef MESH_RESIDENCY_H
+#define MESH_RESIDENCY_H
+
+#include <glm/glm.hpp>
+
+#include "VertexLayout.h"
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// What a mesh keeps in system memory once its buffers are uploaded. Drawing
+// only needs the GPU copy, the CPU one is for whatever reads the geometry
+// afterwards (culling, physics, picking)
+enum MeshResidency {
+    RESIDENCY_FULL,      // every Vertex and index, as loaded
+    RESIDENCY_QUANTIZED, // positions, normals and UVs at 16 bytes a vertex, plus the indices
+    RESIDENCY_DISCARD,   // nothing, the mesh can only be drawn
+    MESH_RESIDENCY_COUNT
+};
+
+inline const char* meshResidencyName(MeshResidency residency)
+{
+    static const char* names[MESH_RESIDENCY_COUNT] = { "full", "quantized", "discard" };
+    return names[residency];
+}
+
+inline bool parseMeshResidency(const std::string& name, MeshResidency& residency)
+{
+    for (int i = 0; i < MESH_RESIDENCY_COUNT; i++) {
+        if (name == meshResidencyName((MeshResidency)i)) {
+            residency = (MeshResidency)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// The RESIDENCY_QUANTIZED copy, the same encoding as the quantized shell
+// stream (see VertexQuantization)
+struct QuantizedVertexCopy {
+    std::vector<QuantizedShellVertex> vertices;
+    VertexQuantization quantization;
+
+    glm::vec3 position(size_t i) const { return quantization.decodePosition(vertices[i]); }
+    glm::vec3 normal(size_t i) const { return quantization.decodeNormal(vertices[i]); }
+    size_t bytes() const { return vertices.capacity() * sizeof(QuantizedShellVertex); }
+};
+
+// Drops or compacts a mesh's CPU data to the policy, after the upload
+inline void applyMeshResidency(MeshResidency residency, std::vector<Vertex>& vertices,
+                               std::vector<unsigned int>& indices, QuantizedVertexCopy& copy)
+{
+    if (residency == RESIDENCY_FULL)
+        return;
+    if (residency == RESIDENCY_QUANTIZED) {
+        copy.quantization = VertexQuantization::fromBounds(vertices);
+        std::vector<unsigned char> packed;
+        packVertexStream(STREAM_SHELL_QUANTIZED, vertices, packed, &copy.quantization);
+        copy.vertices.resize(vertices.size());
+        std::memcpy(copy.vertices.data(), packed.data(), packed.size());
+    } else
+        std::vector<unsigned int>().swap(indices);
+    // clear() alone would keep the capacity
+    std::vector<Vertex>().swap(vertices);
+}
+
+// Where one or more meshes' bytes live, to compare residency policies
+struct MeshMemory {
+    size_t meshes = 0;
+    size_t cpuBytes = 0;     // what the policy kept
+    size_t fullCpuBytes = 0; // what RESIDENCY_FULL would keep
+    size_t gpuBytes = 0;
+
+    static MeshMemory of(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                         const QuantizedVertexCopy& copy, const VertexBuffers& buffers)
+    {
+        return of(vertices, indices, copy, buffers.vertexCount, (size_t)buffers.indexCount, buffers.bytes());
+    }
+
+    // uploaded vertexCount vertices and indexCount indices into gpuBytes
+    static MeshMemory of(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                         const QuantizedVertexCopy& copy, size_t vertexCount, size_t indexCount, size_t gpuBytes)
+    {
+        MeshMemory memory;
+        memory.meshes = 1;
+        memory.cpuBytes = vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(unsigned int) +
+                          copy.bytes();
+        memory.fullCpuBytes = vertexCount * sizeof(Vertex) + indexCount * sizeof(unsigned int);
+        memory.gpuBytes = gpuBytes;
+        return memory;
+    }
+
+    void add(const MeshMemory& other)
+    {
+        meshes += other.meshes;
+        cpuBytes += other.cpuBytes;
+        fullCpuBytes += other.fullCpuBytes;
+        gpuBytes += other.gpuBytes;
+    }
+
+    void report(const std::string& name, MeshResidency residency) const
+    {
+        const double MB = 1024.0 * 1024.0;
+        std::cout << "Mesh memory: " << name << " (" << meshes << (meshes == 1 ? " mesh, " : " meshes, ")
+                  << meshResidencyName(residency)
+                  << ") CPU " << cpuBytes / MB << " MB, full data would be " << fullCpuBytes / MB
+                  << " MB, saves " << ((double)fullCpuBytes - (double)cpuBytes) / MB << " MB. GPU "
+                  << gpuBytes / MB << " MB" << std::endl;
+    }
+};
+#endif
@@ -0,0 +1,321 @@
+#ifndef MESHLETS_H
+#define MESHLETS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Profiler.h"
+#include "UniformBlocks.h"
+#include "VertexLayout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A patch of at most Meshlets::MAX_TRIANGLES neighbouring triangles, with
+// bounds for culling it in model space
+struct Meshlet {
+    unsigned int triangleCount = 0;
+    glm::vec3 center = glm::vec3(0.0f); // bounding sphere of the base triangles
+    float radius = 0.0f;
+    glm::vec3 coneAxis = glm::vec3(0.0f, 0.0f, 1.0f); // average outward normal
+    float coneSpread = 0.0f; // radians from the axis to the farthest normal
+};
+
+// Splits a mesh into meshlets and decides every frame which of them the
+// shells can show. GL_CULL_FACE stays off since a strand can reach past the
+// silhouette of its triangle, so instead a meshlet is dropped when
+//  - its bounding sphere, grown by how far a shell reaches from the base
+//    (see shellReach), is outside the view frustum, or
+//  - every normal in its cone faces away from the eye. Back facing alone
+//    isn't enough, fur just behind the silhouette still sticks out past
+//    it, so the cone is widened by how far a surface can turn away and
+//    still show fur: acos(R / (R + reach)) on a sphere of radius R, with R
+//    the mesh's bounding radius
+// Either way the opaque base layer covers what is dropped, as long as it
+// writes depth. The visible meshlets' triangles are copied into a second
+// index buffer in their original order, so the layers blend exactly as
+// without culling, and it is uploaded again only when the set changes.
+class Meshlets {
+public:
+    static constexpr size_t MAX_TRIANGLES = 16;
+    static constexpr float HALF_PI = 1.5707963f;
+
+    std::vector<Meshlet> meshlets;
+
+    // totals over every cull(), for the summary
+    long long frames = 0;
+    long long trianglesTotal = 0;
+    long long trianglesDrawn = 0;
+    long long uploads = 0;
+
+    Meshlets() = default;
+    Meshlets(const Meshlets&) = delete;
+    Meshlets& operator=(const Meshlets&) = delete;
+
+    // indexType is the one the mesh was uploaded with
+    void build(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, GLenum indexType)
+    {
+        PROFILE_SCOPE("Meshlets::build");
+        this->indices = indices;
+        this->indexType = indexType;
+        meshlets.clear();
+        size_t triangleCount = indices.size() / 3;
+        meshletOf.assign(triangleCount, UNASSIGNED);
+
+        // triangles around each vertex, as offsets into adjacency
+        std::vector<size_t> firstTriangle(vertices.size() + 1, 0);
+        for (unsigned int index : indices)
+            firstTriangle[index + 1]++;
+        for (size_t v = 0; v < vertices.size(); v++)
+            firstTriangle[v + 1] += firstTriangle[v];
+        std::vector<unsigned int> adjacency(indices.size());
+        std::vector<size_t> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+        for (size_t t = 0; t < triangleCount; t++)
+            for (int c = 0; c < 3; c++)
+                adjacency[fill[indices[t * 3 + c]]++] = (unsigned int)t;
+
+        // grow each meshlet from the first free triangle, always taking the
+        // neighbour closest to where it started, so they come out round
+        // rather than as strips
+        typedef std::pair<float, unsigned int> Candidate;
+        std::vector<glm::vec3> centroids(triangleCount);
+        for (size_t t = 0; t < triangleCount; t++)
+            centroids[t] = (vertices[indices[t * 3]].Position + vertices[indices[t * 3 + 1]].Position +
+                            vertices[indices[t * 3 + 2]].Position) / 3.0f;
+        std::vector<unsigned int> members;
+        for (size_t seed = 0; seed < triangleCount; seed++) {
+            if (meshletOf[seed] != UNASSIGNED)
+                continue;
+            unsigned int id = (unsigned int)meshlets.size();
+            glm::vec3 origin = centroids[seed];
+            std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> frontier;
+            frontier.push({ 0.0f, (unsigned int)seed });
+            members.clear();
+            while (!frontier.empty() && members.size() < MAX_TRIANGLES) {
+                unsigned int t = frontier.top().second;
+                frontier.pop();
+                if (meshletOf[t] != UNASSIGNED)
+                    continue;
+                meshletOf[t] = id;
+                members.push_back(t);
+                for (int c = 0; c < 3; c++) {
+                    unsigned int v = indices[t * 3 + c];
+                    for (size_t a = firstTriangle[v]; a < firstTriangle[v + 1]; a++) {
+                        unsigned int next = adjacency[a];
+                        if (meshletOf[next] == UNASSIGNED)
+                            frontier.push({ glm::length(centroids[next] - origin), next });
+                    }
+                }
+            }
+            meshlets.push_back(bound(vertices, members));
+        }
+
+        // the surface's closest approach to the centre, not the box
+        // diagonal: a larger R narrows acos(R / (R + reach)) and would cull
+        // patches whose fur still shows past the silhouette
+        glm::vec3 low(INFINITY), high(-INFINITY);
+        for (const Vertex& vertex : vertices) {
+            low = glm::min(low, vertex.Position);
+            high = glm::max(high, vertex.Position);
+        }
+        glm::vec3 center = (low + high) * 0.5f;
+        meshRadius = vertices.empty() ? 0.0f : INFINITY;
+        for (const Vertex& vertex : vertices)
+            meshRadius = std::min(meshRadius, glm::length(vertex.Position - center));
+        visible.assign(meshlets.size(), 1);
+        culling = false;
+        if (!EBO)
+            glGenBuffers(1, &EBO);
+    }
+
+    // how far a shell vertex can end up from its base vertex, the sum of
+    // basic.vert's offsets at the outermost layer
+    static float shellReach(const FurBlock& fur)
+    {
+        return fur.furLength + glm::length(fur.gravity) * 0.1f + glm::length(fur.windDirection) * 0.15f;
+    }
+
+    // model space is where both the bounds and the shell offsets live, so the
+    // eye and frustum are brought there rather than the meshlets to world space
+    void cull(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection, float reach)
+    {
+        PROFILE_SCOPE("Meshlets::cull");
+        glm::mat4 clip = projection * view * model;
+        glm::vec4 planes[6];
+        for (int i = 0; i < 3; i++) {
+            glm::vec4 row(clip[0][i], clip[1][i], clip[2][i], clip[3][i]);
+            glm::vec4 w(clip[0][3], clip[1][3], clip[2][3], clip[3][3]);
+            planes[i * 2] = w + row;
+            planes[i * 2 + 1] = w - row;
+        }
+        for (glm::vec4& plane : planes)
+            plane /= glm::length(glm::vec3(plane));
+        glm::vec3 eye = glm::vec3(glm::inverse(view * model) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+        float widen = meshRadius > 0.0f ? std::acos(meshRadius / (meshRadius + reach)) : HALF_PI;
+
+        bool changed = !culling;
+        size_t drawn = 0;
+        for (size_t m = 0; m < meshlets.size(); m++) {
+            const Meshlet& meshlet = meshlets[m];
+            bool inside = true;
+            for (const glm::vec4& plane : planes)
+                inside = inside && glm::dot(glm::vec3(plane), meshlet.center) + plane.w >= -(meshlet.radius + reach);
+            // every normal within spread of the axis faces away from every
+            // point of the bounding sphere
+            float spread = meshlet.coneSpread + widen;
+            glm::vec3 toCenter = meshlet.center - eye;
+            bool hidden = spread < HALF_PI &&
+                glm::dot(toCenter, meshlet.coneAxis) >= std::sin(spread) * glm::length(toCenter) + meshlet.radius;
+            char show = inside && !hidden;
+            changed = changed || visible[m] != show;
+            visible[m] = show;
+            if (show)
+                drawn += meshlet.triangleCount;
+        }
+        if (changed)
+            upload();
+        culling = true;
+        frames++;
+        trianglesTotal += (long long)meshletOf.size();
+        trianglesDrawn += (long long)drawn;
+    }
+
+    // culling off: the mesh's own index buffer, every triangle
+    void showAll()
+    {
+        culling = false;
+    }
+
+    // the visible triangles, instances layers each, with the mesh's VAO bound
+    void draw(const VertexBuffers& buffers, GLsizei instances) const
+    {
+        if (!culling) {
+            glDrawElementsInstanced(GL_TRIANGLES, buffers.indexCount, buffers.indexType, 0, instances);
+            return;
+        }
+        if (culledCount == 0)
+            return;
+        // the element buffer is VAO state, so put the mesh's own one back after
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glDrawElementsInstanced(GL_TRIANGLES, culledCount, indexType, 0, instances);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.elementBuffer());
+    }
+
+    void printSummary(const std::string& name) const
+    {
+        if (frames == 0)
+            return;
+        std::cout << "Meshlets: " << name << " " << meshlets.size() << " meshlets, drew "
+                  << 100.0 * (double)trianglesDrawn / (double)std::max(trianglesTotal, 1LL)
+                  << "% of the triangles over " << frames << " frames, " << uploads << " index uploads"
+                  << std::endl;
+    }
+
+    void destroy()
+    {
+        if (EBO)
+            glDeleteBuffers(1, &EBO);
+        EBO = 0;
+    }
+
+private:
+    static constexpr unsigned int UNASSIGNED = ~0u;
+
+    std::vector<unsigned int> indices;
+    std::vector<unsigned int> meshletOf; // per triangle
+    GLenum indexType = GL_UNSIGNED_INT;
+    float meshRadius = 0.0f; // smallest centre to vertex distance
+    std::vector<char> visible; // per meshlet, from the last cull()
+    bool culling = false;      // draw() uses the compacted indices
+    unsigned int EBO = 0;
+    GLsizei culledCount = 0;
+    std::vector<unsigned char> compacted;
+
+    Meshlet bound(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& triangles) const
+    {
+        Meshlet meshlet;
+        meshlet.triangleCount = (unsigned int)triangles.size();
+
+        // sphere around the box center, close enough for patches this small
+        glm::vec3 low(INFINITY), high(-INFINITY);
+        for (unsigned int t : triangles) {
+            for (int c = 0; c < 3; c++) {
+                low = glm::min(low, vertices[indices[t * 3 + c]].Position);
+                high = glm::max(high, vertices[indices[t * 3 + c]].Position);
+            }
+        }
+        meshlet.center = (low + high) * 0.5f;
+        for (unsigned int t : triangles)
+            for (int c = 0; c < 3; c++)
+                meshlet.radius = std::max(meshlet.radius,
+                                          glm::length(vertices[indices[t * 3 + c]].Position - meshlet.center));
+
+        // the cone has to hold the face normals and the vertex normals the
+        // shells are pushed along. Faces are oriented the way their vertex
+        // normals point, the fur rather than the winding decides what is outside
+        std::vector<glm::vec3> normals;
+        glm::vec3 sum(0.0f);
+        for (unsigned int t : triangles) {
+            const Vertex& a = vertices[indices[t * 3]];
+            const Vertex& b = vertices[indices[t * 3 + 1]];
+            const Vertex& c = vertices[indices[t * 3 + 2]];
+            glm::vec3 vertexNormals = a.Normal + b.Normal + c.Normal;
+            glm::vec3 face = glm::cross(b.Position - a.Position, c.Position - a.Position);
+            float length = glm::length(face);
+            if (length > 0.0f) { // poles of the UV sphere are degenerate
+                face /= length;
+                normals.push_back(glm::dot(face, vertexNormals) < 0.0f ? -face : face);
+            }
+            for (const Vertex* v : { &a, &b, &c })
+                if (glm::length(v->Normal) > 0.0f)
+                    normals.push_back(glm::normalize(v->Normal));
+            sum += vertexNormals;
+        }
+        // a cone 90 degrees or wider always has a normal facing the eye
+        meshlet.coneSpread = HALF_PI;
+        if (normals.empty() || glm::length(sum) == 0.0f)
+            return meshlet;
+        meshlet.coneAxis = glm::normalize(sum);
+        float minDot = 1.0f;
+        for (const glm::vec3& normal : normals)
+            minDot = std::min(minDot, glm::dot(normal, meshlet.coneAxis));
+        if (minDot > 0.0f)
+            meshlet.coneSpread = std::acos(std::min(minDot, 1.0f));
+        return meshlet;
+    }
+
+    // the visible meshlets' triangles in the mesh's order and index type
+    void upload()
+    {
+        size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+        compacted.resize(indices.size() * indexSize);
+        size_t count = 0;
+        for (size_t t = 0; t < meshletOf.size(); t++) {
+            if (!visible[meshletOf[t]])
+                continue;
+            for (int c = 0; c < 3; c++, count++) {
+                unsigned int index = indices[t * 3 + c];
+                if (indexType == GL_UNSIGNED_SHORT) {
+                    uint16_t shortIndex = (uint16_t)index;
+                    std::memcpy(&compacted[count * indexSize], &shortIndex, indexSize);
+                } else
+                    std::memcpy(&compacted[count * indexSize], &index, indexSize);
+            }
+        }
+        culledCount = (GLsizei)count;
+        // not through the VAO, binding an element buffer would change it
+        glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+        glBufferData(GL_COPY_WRITE_BUFFER, count * indexSize, compacted.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        uploads++;
+    }
+};
+#endif
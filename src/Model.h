@@ -10,82 +10,96 @@
 
 #include "Shader.h"
 #include "Mesh.h"
+#include "GeometryArena.h"
+#include "Profiler.h"
 
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
-#define MAX_BONE_INFLUENCE 4
-
 unsigned int TextureFromFile(const char *path, const std::string &directory, bool gamma = false);
 
 class Model {
 public:
-    // model data
+    // every mesh's vertices and indices, declared first so the meshes are
+    // destroyed before it. Null with quantized streams, then each mesh has
+    // its own buffers (see GeometryArena)
+    std::unique_ptr<GeometryArena> arena;
+    // model data, Mesh is move-only so they are built in place
     std::vector<Mesh> meshes;
     std::string directory;
     std::vector<Texture> textures_loaded;
     bool gammaCorrection;
+    unsigned int streams; // VertexStreamMask uploaded for every mesh
+    MeshResidency residency; // CPU data every mesh keeps after upload
 
-    // constructor, expects a file path to a 3D model
-    Model (std::string const &path, bool gamma =false) : gammaCorrection(gamma)
+    // constructor, expects a file path to a 3D model. streams are the vertex
+    // data the pipeline drawing it reads, see VertexLayout.h, residency what
+    // stays in system memory, see MeshResidency.h
+    Model (std::string const &path, bool gamma =false, unsigned int streams = STREAMS_SHELL,
+           MeshResidency residency = RESIDENCY_FULL)
+        : gammaCorrection(gamma), streams(streams), residency(residency)
     {
+        if (!(streams & STREAMS_SHELL_QUANTIZED))
+            arena.reset(new GeometryArena(streams));
         loadModel(path);
     }
-    // draws the model and all its meshes
-    void Draw(Shader &shader)
-    {
-        for(unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shader);
-    }
-private:
-    // loads a model with ASSIMP extensions and stores meshes in mesh vector
-    void loadModel(std::string const &path) 
+    // draws the model and all its meshes, instances times with instances > 1.
+    // From the arena the VAO is bound once and consecutive meshes with the
+    // same textures go out as one multi-draw. decode is resolved once per
+    // shader, see VertexDecodeUniforms::resolve
+    void Draw(Shader &shader, const VertexDecodeUniforms &decode, GLsizei instances = 1)
     {
-        // read file via ASSIMP
-        Assimp::Importer import;
-        const aiScene *scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
-        // aiProcess_GenNormals (creates normals), aiProcess_SplitLargeMeshes (splits large meshes)
-        // aiProcess_OptimizeMeshes (joins meshes reducing draw calls)
-
-        // checks for errors
-        if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if not zero
-        {
-            std::cout << "ERROR::ASSIMP::" << import.GetErrorString() << std::endl;
+        if (!arena) {
+            for(unsigned int i = 0; i < meshes.size(); i++)
+                meshes[i].Draw(shader, decode, instances);
             return;
         }
-        // Gets the directory path of the filepath
-        directory = path.substr(0, path.find_last_of('/'));
-        // process ASSIMP's root node recursively
-        processNode(scene->mRootNode, scene);
+        drawFromArena(shader, decode, *arena, meshes, instances, batch);
     }
-
-    void processNode(aiNode *node, const aiScene *scene) 
+    // the arena half of Draw, for meshes that all live in arena. Static so
+    // it can be benchmarked without loading a file; batch is scratch space
+    static void drawFromArena(Shader &shader, const VertexDecodeUniforms &decode, GeometryArena &arena,
+                              const std::vector<Mesh> &meshes, GLsizei instances,
+                              std::vector<const GeometryArena::Allocation*> &batch)
     {
-        // process all the node's meshes (if any)
-        for(unsigned int i = 0; i < node->mNumMeshes; i++)
-        {
-            // the node object only contains indices to index the actual object in the scene
-            // the scene contains all the data, node is just to keep stuff organized
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
-        }
-        // then do the same for each of its children
-        for(unsigned int i = 0; i < node->mNumChildren; i++)
-        {
-            processNode(node->mChildren[i], scene); // recursively process
+        shader.setBool(decode.quantized, false);
+        glBindVertexArray(arena.VAO);
+        batch.clear();
+        for (size_t i = 0; i < meshes.size(); i++) {
+            if (i == 0 || !meshes[i].sameTextures(meshes[i - 1])) {
+                arena.drawMulti(batch, instances);
+                batch.clear();
+                meshes[i].bindTextures(shader);
+            }
+            batch.push_back(&meshes[i].arenaAllocation());
         }
+        arena.drawMulti(batch, instances);
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
     }
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene) 
+    // summed over every mesh, see MeshMemory::report
+    MeshMemory memory() const
     {
-        // data to fill
-        std::vector<Vertex> vertices;
-        std::vector<unsigned int> indices;
-        std::vector<Texture> textures;
+        MeshMemory total;
+        for (const Mesh& mesh : meshes)
+            total.add(mesh.memory());
+        return total;
+    }
+    // converts assimp's vertex and face arrays into our layout, no GL calls
+    // so it can be run (and benchmarked) without a context
+    static void extractGeometry(const aiMesh *mesh, std::vector<Vertex> &vertices,
+                                std::vector<unsigned int> &indices)
+    {
+        vertices.reserve(vertices.size() + mesh->mNumVertices);
+        indices.reserve(indices.size() + mesh->mNumFaces * 3);
 
-        // walk through each of the mesh's vertices
+        // walk through each of the mesh's vertices, filled where they end up
+        // (value initialized, so bone slots and missing attributes are zero)
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
         {
-            Vertex vertex;
+            Vertex& vertex = vertices.emplace_back();
             glm::vec3 vector; // we declare a placeholder vector since assimp uses its own
             // vector class that doesn't directly convert to glm's vec3 class so we transfer
             // the data to placeholder glm::vec3 first
@@ -128,17 +142,79 @@ private:
             }
             else
                 vertex.TexCoords = glm::vec2(0.0f, 0.0f);
-
-            vertices.push_back(vertex);
         }
         // now walk through each of the mesh's faces(its triangles) and get correspond vertex indices
         for(unsigned int i = 0; i < mesh->mNumFaces; i++)
         {
-            aiFace face = mesh->mFaces[i];
+            const aiFace& face = mesh->mFaces[i];
             // retrieve all indices of the face and store them in indices vertex
             for(unsigned int j = 0; j < face.mNumIndices; j++)
                 indices.push_back(face.mIndices[j]);
         }
+    }
+private:
+    std::vector<const GeometryArena::Allocation*> batch; // Draw's, kept between frames
+
+    // loads a model with ASSIMP extensions and stores meshes in mesh vector
+    void loadModel(std::string const &path) 
+    {
+        PROFILE_SCOPE("Model::loadModel");
+        // read file via ASSIMP
+        Assimp::Importer import;
+        const aiScene *scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        // aiProcess_GenNormals (creates normals), aiProcess_SplitLargeMeshes (splits large meshes)
+        // aiProcess_OptimizeMeshes (joins meshes reducing draw calls)
+
+        // checks for errors
+        if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if not zero
+        {
+            std::cout << "ERROR::ASSIMP::" << import.GetErrorString() << std::endl;
+            return;
+        }
+        // Gets the directory path of the filepath
+        directory = path.substr(0, path.find_last_of('/'));
+        // process ASSIMP's root node recursively, meshes never reallocates
+        // unless nodes share meshes
+        meshes.reserve(meshes.size() + scene->mNumMeshes);
+        // and the arena is sized once, unless nodes share meshes
+        if (arena) {
+            size_t vertexTotal = 0, indexTotal = 0;
+            for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+                vertexTotal += scene->mMeshes[i]->mNumVertices;
+                indexTotal += (size_t)scene->mMeshes[i]->mNumFaces * 3;
+            }
+            arena->reserve(vertexTotal, indexTotal);
+        }
+        processNode(scene->mRootNode, scene);
+    }
+
+    void processNode(aiNode *node, const aiScene *scene) 
+    {
+        // process all the node's meshes (if any)
+        for(unsigned int i = 0; i < node->mNumMeshes; i++)
+        {
+            // the node object only contains indices to index the actual object in the scene
+            // the scene contains all the data, node is just to keep stuff organized
+            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+            processMesh(mesh, scene);
+        }
+        // then do the same for each of its children
+        for(unsigned int i = 0; i < node->mNumChildren; i++)
+        {
+            processNode(node->mChildren[i], scene); // recursively process
+        }
+    }
+    // appends the mesh to meshes, its vertex data moved rather than copied
+    void processMesh(aiMesh *mesh, const aiScene *scene) 
+    {
+        PROFILE_SCOPE("Model::processMesh");
+        // data to fill
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        std::vector<Texture> textures;
+
+        extractGeometry(mesh, vertices, indices);
+
         // process materials
         aiMaterial *material = scene->mMaterials[mesh->mMaterialIndex];
 
@@ -159,8 +235,11 @@ private:
                                                             "texture_height");
         textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
-        // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        // create the mesh in place from the extracted mesh data
+        if (arena)
+            meshes.emplace_back(std::move(vertices), std::move(indices), std::move(textures), *arena, residency);
+        else
+            meshes.emplace_back(std::move(vertices), std::move(indices), std::move(textures), streams, residency);
     }
     // checks all material textures of a given type and loads the textures if not alr loaded.
     // the required info is returned as a Texture struct
@@ -201,6 +280,7 @@ private:
 };
 unsigned int TextureFromFile(const char *path, const std::string &directory, bool gamma)
 {
+    PROFILE_SCOPE("TextureFromFile");
     std::string filename = std::string(path);
     filename = directory + '/' + filename;
 
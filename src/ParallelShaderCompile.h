@@ -0,0 +1,61 @@
+#ifndef PARALLEL_SHADER_COMPILE_H
+#define PARALLEL_SHADER_COMPILE_H
+
+#include <glad/glad.h>
+
+#include <cstring>
+#include <iostream>
+
+// KHR/ARB_parallel_shader_compile, not part of the GLAD 3.3 loader
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// With KHR_parallel_shader_compile the driver compiles and links on its own
+// threads, and GL_COMPLETION_STATUS_KHR says whether a shader or program is
+// done without waiting for it. Without the extension the first status query
+// blocks until the driver is done, so Shader can only find out by waiting.
+class ParallelShaderCompile {
+public:
+    static inline bool available = false;
+
+    // call after gladLoadGLLoader with the same loader
+    static void init(GLADloadproc load)
+    {
+        available = false;
+        typedef void (APIENTRYP MaxShaderCompilerThreadsProc)(GLuint);
+        MaxShaderCompilerThreadsProc maxThreads = nullptr;
+        if (hasExtension("GL_KHR_parallel_shader_compile"))
+            maxThreads = (MaxShaderCompilerThreadsProc)load("glMaxShaderCompilerThreadsKHR");
+        else if (hasExtension("GL_ARB_parallel_shader_compile"))
+            maxThreads = (MaxShaderCompilerThreadsProc)load("glMaxShaderCompilerThreadsARB");
+        if (!maxThreads) {
+            std::cout << "Shader compile: no parallel_shader_compile, programs finish one per frame" << std::endl;
+            return;
+        }
+        maxThreads(0xFFFFFFFFu); // let the driver pick
+        available = true;
+    }
+
+    // true once the program (or shader) no longer blocks a status query
+    static bool isComplete(unsigned int program)
+    {
+        GLint done = GL_TRUE;
+        glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &done);
+        return done != GL_FALSE;
+    }
+
+private:
+    static bool hasExtension(const char* name)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++) {
+            const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+            if (extension && std::strcmp(extension, name) == 0)
+                return true;
+        }
+        return false;
+    }
+};
+#endif
@@ -0,0 +1,188 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+// Scoped CPU zones with Chrome trace / Perfetto export.
+//
+// Each thread appends into its own list of fixed-size chunks. Only the owning
+// thread writes, and it publishes the new event count with a release store,
+// so recording takes no locks and the exporter can read at any time. When
+// profiling is off a zone costs one relaxed atomic load, which is why the
+// zones stay compiled into release builds. Build with -DSHELL_PROFILER=0 to
+// turn every zone into a no-op.
+
+#ifndef SHELL_PROFILER
+#define SHELL_PROFILER 1
+#endif
+
+struct ProfileEvent {
+    const char* name;   // must outlive the profiler, use string literals
+    int64_t startNs;    // since process start
+    int64_t durationNs;
+};
+
+struct ProfileChunk {
+    static const int SIZE = 4096;
+    ProfileEvent events[SIZE];
+    std::atomic<int> count{0};
+    std::atomic<ProfileChunk*> next{nullptr};
+};
+
+struct ProfileThread {
+    std::string name;
+    int id = 0;
+    ProfileChunk* head = nullptr;
+    ProfileChunk* tail = nullptr;   // only touched by the owning thread
+    size_t recorded = 0;            // only touched by the owning thread
+    std::atomic<size_t> dropped{0};
+    ProfileThread* nextThread = nullptr;
+};
+
+class Profiler {
+public:
+    // caps memory per thread, later events are counted as dropped
+    static const size_t MAX_EVENTS_PER_THREAD = 1 << 20;
+
+    static inline std::atomic<bool> enabled{false};
+
+    static int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    static void setThreadName(const std::string& name)
+    {
+        threadState()->name = name;
+    }
+
+    static void record(const char* name, int64_t startNs, int64_t endNs)
+    {
+        ProfileThread* thread = threadState();
+        ProfileChunk* chunk = thread->tail;
+        int count = chunk->count.load(std::memory_order_relaxed);
+        if (count == ProfileChunk::SIZE) {
+            if (thread->recorded >= MAX_EVENTS_PER_THREAD) {
+                thread->dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            ProfileChunk* fresh = new ProfileChunk;
+            chunk->next.store(fresh, std::memory_order_release);
+            thread->tail = chunk = fresh;
+            count = 0;
+        }
+        chunk->events[count] = { name, startNs, endNs - startNs };
+        chunk->count.store(count + 1, std::memory_order_release);
+        thread->recorded++;
+    }
+
+    // writes every event recorded so far in Chrome's trace event format,
+    // loads in chrome://tracing and ui.perfetto.dev
+    static bool writeChromeTrace(const std::string& path)
+    {
+        std::ofstream out(path);
+        if (!out) {
+            std::cout << "ERROR::PROFILER::COULD_NOT_OPEN " << path << std::endl;
+            return false;
+        }
+        // microseconds with ns decimals, the default 6 significant digits
+        // would turn timestamps past 1 s into 1.23457e+06
+        out << std::fixed << std::setprecision(3);
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool first = true;
+        size_t written = 0, dropped = 0;
+        for (ProfileThread* thread = threads.load(std::memory_order_acquire); thread;
+             thread = thread->nextThread) {
+            if (!thread->name.empty()) {
+                out << (first ? "" : ",\n")
+                    << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->id
+                    << ",\"args\":{\"name\":\"" << thread->name << "\"}}";
+                first = false;
+            }
+            for (ProfileChunk* chunk = thread->head; chunk;
+                 chunk = chunk->next.load(std::memory_order_acquire)) {
+                int count = chunk->count.load(std::memory_order_acquire);
+                for (int i = 0; i < count; i++) {
+                    const ProfileEvent& e = chunk->events[i];
+                    out << (first ? "" : ",\n")
+                        << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->id
+                        << ",\"ts\":" << e.startNs / 1000.0 << ",\"dur\":" << e.durationNs / 1000.0 << "}";
+                    first = false;
+                    written++;
+                }
+            }
+            dropped += thread->dropped.load(std::memory_order_relaxed);
+        }
+        out << "\n]}\n";
+
+        std::cout << "Profiler: wrote " << written << " zones to " << path;
+        if (dropped > 0)
+            std::cout << " (" << dropped << " dropped, buffer full)";
+        std::cout << std::endl;
+        return (bool)out;
+    }
+
+private:
+    static inline const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    static inline std::atomic<ProfileThread*> threads{nullptr};
+    static inline std::atomic<int> nextThreadId{1};
+
+    // registers the calling thread on first use, lock-free push onto the list
+    static ProfileThread* threadState()
+    {
+        thread_local ProfileThread* state = nullptr;
+        if (!state) {
+            state = new ProfileThread;
+            state->id = nextThreadId.fetch_add(1);
+            state->head = state->tail = new ProfileChunk;
+            ProfileThread* head = threads.load(std::memory_order_relaxed);
+            do {
+                state->nextThread = head;
+            } while (!threads.compare_exchange_weak(head, state, std::memory_order_release,
+                                                    std::memory_order_relaxed));
+        }
+        return state;
+    }
+};
+
+// Times the enclosing scope, or until end() is called
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name)
+        : name(name), startNs(-1)
+    {
+#if SHELL_PROFILER
+        if (Profiler::enabled.load(std::memory_order_relaxed))
+            startNs = Profiler::nowNs();
+#endif
+    }
+
+    ~ProfileScope()
+    {
+        end();
+    }
+
+    void end()
+    {
+        if (startNs >= 0) {
+            Profiler::record(name, startNs, Profiler::nowNs());
+            startNs = -1;
+        }
+    }
+
+private:
+    const char* name;
+    int64_t startNs;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#endif
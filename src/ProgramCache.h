@@ -0,0 +1,192 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// GL 4.1 / ARB_get_program_binary, not part of the GLAD 3.3 loader
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+// On-disk cache of linked programs (glGetProgramBinary), so startup can skip
+// compiling and linking shaders it has seen before. Entries are keyed by a
+// hash of the sources, the defines and the driver's vendor/renderer/version
+// strings, since binaries are only valid on the driver that produced them.
+// A driver may still reject a binary (e.g. after an update that kept the
+// version string), Shader then compiles from source as if it was a miss.
+class ProgramCache {
+public:
+    static inline std::string directory; // empty while the cache is off
+    static inline int hits = 0;
+    static inline int misses = 0;
+    static inline int rejected = 0;
+    static inline double savedMs = 0.0;  // compile time of the hits minus their load time
+
+    // call after gladLoadGLLoader with the same loader. Leaves the cache off
+    // if the context can't hand out program binaries
+    static bool init(GLADloadproc load, const std::string& dir)
+    {
+        directory.clear();
+        if (dir.empty())
+            return false;
+        getProgramBinary = (GetProgramBinaryProc)load("glGetProgramBinary");
+        programBinary = (ProgramBinaryProc)load("glProgramBinary");
+        programParameteri = (ProgramParameteriProc)load("glProgramParameteri");
+        GLint formats = 0;
+        if (getProgramBinary && programBinary && programParameteri)
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        if (formats <= 0) {
+            std::cout << "Shader cache: driver has no program binary formats, compiling from source" << std::endl;
+            return false;
+        }
+        std::error_code error;
+        std::filesystem::create_directories(dir, error);
+        if (error) {
+            std::cout << "ERROR::PROGRAM_CACHE::COULD_NOT_CREATE " << dir << std::endl;
+            return false;
+        }
+        directory = dir;
+        return true;
+    }
+
+    static bool enabled() { return !directory.empty(); }
+
+    // FNV-1a over everything that decides what the driver would produce
+    static std::string key(std::string_view vertexCode, std::string_view fragmentCode,
+                           std::string_view defines)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        auto add = [&hash](std::string_view text) {
+            for (char c : text)
+                hash = (hash ^ (unsigned char)c) * 1099511628211ull;
+            hash = (hash ^ 0xFF) * 1099511628211ull; // separator, so "ab"+"c" != "a"+"bc"
+        };
+        add((const char*)glGetString(GL_VENDOR));
+        add((const char*)glGetString(GL_RENDERER));
+        add((const char*)glGetString(GL_VERSION));
+        add(defines);
+        add(vertexCode);
+        add(fragmentCode);
+        char text[17];
+        snprintf(text, sizeof(text), "%016llx", (unsigned long long)hash);
+        return text;
+    }
+
+    // linked program from the cache, or 0 on a miss or rejected binary
+    static unsigned int load(const std::string& key)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::ifstream in(path(key), std::ios::binary);
+        FileHeader header;
+        if (!in || !in.read((char*)&header, sizeof(header)) || header.magic != MAGIC ||
+            header.version != VERSION) {
+            misses++;
+            return 0;
+        }
+        std::vector<char> binary(header.length);
+        if (!in.read(binary.data(), binary.size())) {
+            misses++;
+            return 0;
+        }
+
+        unsigned int program = glCreateProgram();
+        programBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+        GLint linked = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            glDeleteProgram(program);
+            std::error_code error;
+            std::filesystem::remove(path(key), error);
+            rejected++;
+            return 0;
+        }
+        double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        hits++;
+        savedMs += header.compileMs - loadMs;
+        return program;
+    }
+
+    // before glLinkProgram on a program that will be stored
+    static void prepare(unsigned int program)
+    {
+        programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    // after a successful link. Written to a temporary file first so a second
+    // instance starting at the same time never reads half an entry
+    static void store(const std::string& key, unsigned int program, double compileMs)
+    {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+        std::vector<char> binary(length);
+        FileHeader header = { MAGIC, VERSION, 0, 0, (float)compileMs };
+        GLsizei written = 0;
+        getProgramBinary(program, length, &written, &header.format, binary.data());
+        header.length = (uint32_t)written;
+
+        std::string target = path(key);
+        std::string temporary = target + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary);
+            out.write((const char*)&header, sizeof(header));
+            out.write(binary.data(), written);
+            if (!out) {
+                std::cout << "ERROR::PROGRAM_CACHE::COULD_NOT_WRITE " << temporary << std::endl;
+                return;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, target, error);
+    }
+
+    static void printSummary()
+    {
+        if (!enabled())
+            return;
+        std::cout << "Shader cache: " << hits << " hits, " << misses << " misses";
+        if (rejected > 0)
+            std::cout << ", " << rejected << " rejected by the driver";
+        if (hits > 0)
+            std::cout << ", saved " << savedMs << " ms";
+        std::cout << std::endl;
+    }
+
+private:
+    static constexpr uint32_t MAGIC = 0x42504853u; // "SHPB"
+    static constexpr uint32_t VERSION = 1;
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        GLenum format;
+        uint32_t length;
+        float compileMs;   // what loading this entry saves
+    };
+
+    typedef void (APIENTRYP GetProgramBinaryProc)(GLuint, GLsizei, GLsizei*, GLenum*, void*);
+    typedef void (APIENTRYP ProgramBinaryProc)(GLuint, GLenum, const void*, GLsizei);
+    typedef void (APIENTRYP ProgramParameteriProc)(GLuint, GLenum, GLint);
+    static inline GetProgramBinaryProc getProgramBinary = nullptr;
+    static inline ProgramBinaryProc programBinary = nullptr;
+    static inline ProgramParameteriProc programParameteri = nullptr;
+
+    static std::string path(const std::string& key)
+    {
+        return directory + "/" + key + ".bin";
+    }
+};
+#endif
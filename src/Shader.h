@@ -6,134 +6,361 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "Profiler.h"
+#include "ProgramCache.h"
+#include "ParallelShaderCompile.h"
+#include "ShaderPreprocessor.h"
+
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// Uniform location resolved ahead of time with Shader::uniform, so setting
+// it needs neither a string nor a driver lookup. -1 (inactive) is ignored by GL.
+// Only valid for the Shader that resolved it
+struct UniformHandle {
+    int location = -1;
+    int slot = -1;     // index of the value shadow in that Shader
+};
+
+// uniform uploads that reached GL and those skipped because GL already had
+// the value, summed over every Shader and UniformBuffer
+struct UniformUploadStats {
+    static inline long long issued = 0;
+    static inline long long elided = 0;
+};
 
 class Shader
 {
 public:
     unsigned int ID;
+    // every active uniform by name (to its shadow slot), filled once after linking
+    std::unordered_map<std::string, int> uniformSlots;
 
-Shader(const char* vertexPath, const char* fragmentPath)
-{
-    // 1. retrieve the vertex/fragment source from the given filepath
-    std::string vertexCode;
-    std::string fragmentCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
-    // ensure ifstream objects can throw exceptions:
-    vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-    try 
-    {
-        // open files
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
-        // read file's buffer contents into streams
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();		
-        // close file handlers
-        vShaderFile.close();
-        fShaderFile.close();
-        // convert stream into string
-        vertexCode   = vShaderStream.str();
-        fragmentCode = fShaderStream.str();		
+// vertexName/fragmentName are relative to the shaders directory, see
+// ShaderSource. defines select a variant, see ShaderPreprocessor. With async
+// the compile and link are only submitted to the driver, poll ready() or call
+// wait() before using the program
+Shader(const char* vertexName, const char* fragmentName, const std::vector<std::string>& defines = {},
+       bool async = false)
+    // 1. retrieve the vertex/fragment source, with includes expanded
+    : Shader(ShaderSource::load(vertexName, defines), ShaderSource::load(fragmentName, defines), defines, async)
+{
+}
+// from sources preprocessed elsewhere, e.g. off the render thread by ShaderReloader
+Shader(const ShaderSource& vertexSource, const ShaderSource& fragmentSource,
+       const std::vector<std::string>& defines, bool async)
+{
+    PROFILE_SCOPE("Shader::Shader");
+    vertexFiles = vertexSource.legend;
+    fragmentFiles = fragmentSource.legend;
+    sourceFiles = vertexSource.files;
+    sourceFiles.insert(sourceFiles.end(), fragmentSource.files.begin(), fragmentSource.files.end());
+
+    // 2. reuse the linked program from an earlier run if there is one
+    ID = 0;
+    if (ProgramCache::enabled()) {
+        std::string defineList;
+        for (const std::string& define : defines)
+            defineList += define + ";";
+        cacheKey = ProgramCache::key(vertexSource.data(), fragmentSource.data(), defineList);
+        ID = ProgramCache::load(cacheKey);
     }
-    catch(const std::ifstream::failure& e)
-    {
-        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+    if (ID != 0) {
+        linkedOk = true;
+        reflectUniforms();
+        return;
+    }
+    submit(vertexSource, fragmentSource);
+    if (!async)
+        wait();
+}
+
+// true once the program is linked (or failed to, see linked()). Never blocks
+// with KHR_parallel_shader_compile; without it GL can't tell whether the
+// driver is done, so this waits for it
+bool ready()
+{
+    if (!pending)
+        return true;
+    if (ParallelShaderCompile::available && !ParallelShaderCompile::isComplete(ID))
+        return false;
+    finish();
+    return true;
+}
+void wait()
+{
+    if (pending)
+        finish();
+}
+bool isPending() const { return pending; }
+bool linked() const { return linkedOk; }
+// every file the program was built from, includes too
+const std::vector<std::string>& files() const { return sourceFiles; }
+
+// takes over other's program and deletes the current one, so everything
+// holding on to this Shader draws with the new program from now on.
+// Handles resolved before have to be resolved again
+void replaceWith(Shader&& other)
+{
+    other.wait();
+    destroy();
+    *this = std::move(other);
+    other.ID = 0;
+}
+void destroy()
+{
+    if (pending) {
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        pending = false;
     }
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
-
-    // 2. compile shaders
-    unsigned int vertex, fragment;
-    
-    // vertex Shader
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    checkCompileErrors(vertex, "VERTEX");
-    // fragment Shader
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    checkCompileErrors(fragment, "FRAGMENT");
-    
-    // shader Program
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    glLinkProgram(ID);
-    checkCompileErrors(ID, "PROGRAM");
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    glDeleteProgram(ID);
+    ID = 0;
+}
+
+// handle for a uniform, resolve these once and keep them around
+UniformHandle uniform(const std::string &name) const
+{
+    auto it = uniformSlots.find(name);
+    if (it == uniformSlots.end())
+        return {};
+    return { shadows[it->second].location, it->second };
+}
+int getUniformLocation(const std::string &name) const
+{
+    return uniform(name).location;
+}
+// forget the values GL is assumed to hold, for when something outside the
+// setters below changed them
+void resetUniformShadow() const
+{
+    for (UniformShadow& shadow : shadows)
+        shadow.valid = false;
 }
 
 void use() {
+    wait();
     glUseProgram(ID);
 }
+// points a uniform block at a binding point, does nothing if the program
+// has no block of that name
+void bindUniformBlock(const char* blockName, unsigned int binding) const
+{
+    unsigned int index = glGetUniformBlockIndex(ID, blockName);
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(ID, index, binding);
+}
 void setBool(const std::string &name, bool value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    setBool(uniform(name), value);
 }
 void setInt(const std::string &name, int value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    setInt(uniform(name), value);
 }
 void setFloat(const std::string &name, float value) const
 {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    setFloat(uniform(name), value);
 }
 // ------------------------------------------------------------------------
 void setVec2(const std::string &name, const glm::vec2 &value) const
 {
-    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    setVec2(uniform(name), value);
 }
 void setVec2(const std::string &name, float x, float y) const
 {
-    glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+    setVec2(uniform(name), glm::vec2(x, y));
 }
 // ------------------------------------------------------------------------
 void setVec3(const std::string &name, const glm::vec3 &value) const
 {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    setVec3(uniform(name), value);
 }
 void setVec3(const std::string &name, float x, float y, float z) const
 {
-    glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+    setVec3(uniform(name), glm::vec3(x, y, z));
 }
 // ------------------------------------------------------------------------
 void setVec4(const std::string &name, const glm::vec4 &value) const
 {
-    glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+    setVec4(uniform(name), value);
 }
 void setVec4(const std::string &name, float x, float y, float z, float w) const
 {
-    glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+    setVec4(uniform(name), glm::vec4(x, y, z, w));
 }
 // ------------------------------------------------------------------------
 void setMat2(const std::string &name, const glm::mat2 &mat) const
 {
-    glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    setMat2(uniform(name), mat);
 }
 // ------------------------------------------------------------------------
 void setMat3(const std::string &name, const glm::mat3 &mat) const
 {
-    glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    setMat3(uniform(name), mat);
 }
 // ------------------------------------------------------------------------
 void setMat4(const std::string &name, const glm::mat4 &mat) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()),
-                       1, GL_FALSE, glm::value_ptr(mat));
+    setMat4(uniform(name), mat);
 }
 
+// ------------------------------------------------------------------------
+// pre-resolved versions of the setters above, for per-frame uploads.
+// Like them they expect this program to be bound, and skip the GL call when
+// the uniform already holds the value
+void setBool(UniformHandle u, bool value) const { setInt(u, (int)value); }
+void setInt(UniformHandle u, int value) const { if (changed(u, value)) glUniform1i(u.location, value); }
+void setFloat(UniformHandle u, float value) const { if (changed(u, value)) glUniform1f(u.location, value); }
+void setVec2(UniformHandle u, const glm::vec2 &value) const { if (changed(u, value)) glUniform2fv(u.location, 1, &value[0]); }
+void setVec3(UniformHandle u, const glm::vec3 &value) const { if (changed(u, value)) glUniform3fv(u.location, 1, &value[0]); }
+void setVec3(UniformHandle u, float x, float y, float z) const { setVec3(u, glm::vec3(x, y, z)); }
+void setVec4(UniformHandle u, const glm::vec4 &value) const { if (changed(u, value)) glUniform4fv(u.location, 1, &value[0]); }
+void setMat2(UniformHandle u, const glm::mat2 &mat) const { if (changed(u, mat)) glUniformMatrix2fv(u.location, 1, GL_FALSE, &mat[0][0]); }
+void setMat3(UniformHandle u, const glm::mat3 &mat) const { if (changed(u, mat)) glUniformMatrix3fv(u.location, 1, GL_FALSE, &mat[0][0]); }
+void setMat4(UniformHandle u, const glm::mat4 &mat) const { if (changed(u, mat)) glUniformMatrix4fv(u.location, 1, GL_FALSE, glm::value_ptr(mat)); }
+
 private:
-    void checkCompileErrors(unsigned int shader, std::string type)
+    // source string numbers in compile errors, see ShaderPreprocessor
+    std::string vertexFiles, fragmentFiles;
+    std::vector<std::string> sourceFiles;
+
+    // in-flight compile, see submit() and finish()
+    bool pending = false;
+    bool linkedOk = false;
+    unsigned int vertex = 0, fragment = 0;
+    std::string cacheKey;  // empty when the result is not cached
+    std::chrono::steady_clock::time_point submitted;
+
+    // hands the sources to the driver without asking for any status, which
+    // would make it finish compiling right there
+    void submit(const ShaderSource &vertexSource, const ShaderSource &fragmentSource)
+    {
+        submitted = std::chrono::steady_clock::now();
+        const char* strings[ShaderSource::PARTS];
+        int lengths[ShaderSource::PARTS];
+
+        // vertex Shader
+        vertex = glCreateShader(GL_VERTEX_SHADER);
+        vertexSource.parts(strings, lengths);
+        glShaderSource(vertex, ShaderSource::PARTS, strings, lengths);
+        glCompileShader(vertex);
+        // fragment Shader
+        fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        fragmentSource.parts(strings, lengths);
+        glShaderSource(fragment, ShaderSource::PARTS, strings, lengths);
+        glCompileShader(fragment);
+
+        // shader Program
+        ID = glCreateProgram();
+        glAttachShader(ID, vertex);
+        glAttachShader(ID, fragment);
+        if (!cacheKey.empty())
+            ProgramCache::prepare(ID);
+        glLinkProgram(ID);
+        pending = true;
+    }
+
+    // reports errors and sets the program up, blocks until the driver is done
+    void finish()
+    {
+        PROFILE_SCOPE("Shader::finish");
+        pending = false;
+        checkCompileErrors(vertex, "VERTEX", vertexFiles);
+        checkCompileErrors(fragment, "FRAGMENT", fragmentFiles);
+        linkedOk = checkCompileErrors(ID, "PROGRAM");
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        vertex = fragment = 0;
+
+        if (linkedOk && !cacheKey.empty()) {
+            // wall time since submitting, what a cache hit saves at most
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submitted).count();
+            ProgramCache::store(cacheKey, ID, ms);
+        }
+        reflectUniforms();
+    }
+
+    // last value uploaded to one uniform location
+    struct UniformShadow {
+        int location;
+        bool valid;
+        unsigned char value[sizeof(glm::mat4)];
+    };
+    mutable std::vector<UniformShadow> shadows; // by slot
+
+    // compares against the shadow and takes the new value, true if GL needs it.
+    // Inactive uniforms never need it, and are not counted: there was
+    // never an upload to save
+    template <typename T>
+    bool changed(UniformHandle u, const T &value) const
+    {
+        static_assert(sizeof(T) <= sizeof(UniformShadow::value), "uniform larger than its shadow");
+        if (u.slot < 0 || u.slot >= (int)shadows.size())
+            return false;
+        UniformShadow& shadow = shadows[u.slot];
+        if (shadow.valid && std::memcmp(shadow.value, &value, sizeof(T)) == 0) {
+            UniformUploadStats::elided++;
+            return false;
+        }
+        std::memcpy(shadow.value, &value, sizeof(T));
+        shadow.valid = true;
+        UniformUploadStats::issued++;
+        return true;
+    }
+
+    int addSlot(int location)
+    {
+        shadows.push_back({ location, false, {} });
+        return (int)shadows.size() - 1;
+    }
+
+    // asks the linked program for its active uniforms. Struct members come
+    // back as "pointLights[0].linear", arrays of basic types as "name[0]" with
+    // a size, so those are also stored as "name" and "name[i]"
+    void reflectUniforms()
+    {
+        uniformSlots.clear();
+        shadows.clear();
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::string name(std::max(maxLength, 1), '\0');
+        for (GLint i = 0; i < count; i++) {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, &name[0]);
+            if (length <= 0)
+                continue;
+            std::string uniformName = name.substr(0, length);
+            int location = glGetUniformLocation(ID, uniformName.c_str());
+            if (location < 0)
+                continue; // lives in a uniform block
+            int slot = addSlot(location);
+            uniformSlots[uniformName] = slot;
+
+            size_t bracket = uniformName.size() > 3 ? uniformName.size() - 3 : std::string::npos;
+            if (bracket != std::string::npos && uniformName.compare(bracket, 3, "[0]") == 0) {
+                std::string base = uniformName.substr(0, bracket);
+                uniformSlots[base] = slot;
+                for (GLint element = 1; element < size; element++) {
+                    std::string elementName = base + "[" + std::to_string(element) + "]";
+                    uniformSlots[elementName] = addSlot(glGetUniformLocation(ID, elementName.c_str()));
+                }
+            }
+        }
+    }
+
+    // true if compiling or linking succeeded
+    bool checkCompileErrors(unsigned int shader, std::string type, const std::string& files = "")
     {
         int success;
         char infoLog[1024];
@@ -143,7 +370,7 @@ private:
             if (!success)
             {
                 glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-                std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
+                std::cout << "ERROR::SHADER_COMPILATION_ERROR of type: " << type << " (" << files << ")\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
             }
         }
         else
@@ -155,6 +382,7 @@ private:
                 std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
             }
         }
+        return success != 0;
     }
 };
 #endif
\ No newline at end of file
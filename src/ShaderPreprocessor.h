@@ -0,0 +1,203 @@
+#ifndef SHADER_PREPROCESSOR_H
+#define SHADER_PREPROCESSOR_H
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Expands #include "file" (relative to the including file, each file at most
+// once). Right after #version it leaves room for the defines ShaderSource
+// injects, so one source file can be compiled into several variants.
+//
+// Every file gets a GLSL source string number through #line, so compile
+// errors like "2:14(3): error" mean line 14 of files[2].
+class ShaderPreprocessor {
+public:
+    std::vector<std::string> files; // by source string number
+
+    bool process(const std::string& path, std::string& out)
+    {
+        files.clear();
+        included.clear();
+        std::ostringstream stream;
+        bool ok = expand(path, stream, true);
+        out = stream.str();
+        return ok;
+    }
+
+    // "0 = ../shaders/basic.frag, 1 = ..." for compile errors
+    std::string legend() const
+    {
+        std::string text;
+        for (size_t i = 0; i < files.size(); i++)
+            text += (i > 0 ? ", " : "") + std::to_string(i) + " = " + files[i];
+        return text;
+    }
+
+private:
+    std::set<std::string> included;
+
+    bool expand(const std::string& path, std::ostringstream& out, bool root)
+    {
+        std::error_code error;
+        std::string canonical = std::filesystem::weakly_canonical(path, error).string();
+        if (error)
+            canonical = path;
+        if (!included.insert(canonical).second)
+            return true; // already pulled in by another #include
+
+        std::ifstream file(path);
+        if (!file) {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ " << path << std::endl;
+            return false;
+        }
+        int fileIndex = (int)files.size();
+        files.push_back(path);
+        if (!root)
+            out << "#line 1 " << fileIndex << "\n";
+
+        std::filesystem::path directory = std::filesystem::path(path).parent_path();
+        std::string line;
+        int lineNumber = 0;
+        bool ok = true;
+        while (std::getline(file, line)) {
+            lineNumber++;
+            std::string includePath;
+            if (parseInclude(line, includePath)) {
+                ok = expand((directory / includePath).string(), out, false) && ok;
+                out << "#line " << lineNumber + 1 << " " << fileIndex << "\n";
+                continue;
+            }
+            out << line << "\n";
+            // the defines go in before this #line, see ShaderSource
+            if (root && line.compare(0, 8, "#version") == 0)
+                out << "#line " << lineNumber + 1 << " " << fileIndex << "\n";
+        }
+        return ok;
+    }
+
+    // #include "name", leading whitespace allowed
+    static bool parseInclude(const std::string& line, std::string& includePath)
+    {
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+            return false;
+        size_t open = line.find('"', start + 8);
+        size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+        if (close == std::string::npos) {
+            std::cout << "ERROR::SHADER::BAD_INCLUDE " << line << std::endl;
+            return false;
+        }
+        includePath = line.substr(open + 1, close - open - 1);
+        return true;
+    }
+};
+
+#ifdef SHELL_EMBEDDED_SHADERS
+// one shaders/ file with its #includes expanded, compiled into the executable
+struct EmbeddedShader {
+    const char* name;   // relative to shaders/, e.g. "basic.frag"
+    const char* source;
+    size_t length;
+    const char* files;  // by source string number, '\n' separated
+};
+#include "EmbeddedShaders.h" // generated by tools/embed_shaders.cpp
+#endif
+
+// One preprocessed stage, ready for Shader to compile. Shaders are named
+// relative to the shaders directory ("basic.frag"). Builds that embed them
+// (SHELL_EMBEDDED_SHADERS) use the copies in the executable unless a
+// directory is set; the text is then handed to GL in place, the defines
+// going in as a separate string after #version. Loading only touches files,
+// so it can run on any thread.
+struct ShaderSource {
+#ifdef SHELL_EMBEDDED_SHADERS
+    static inline std::string directory;                // empty uses the embedded shaders
+#else
+    static inline std::string directory = "../shaders";
+#endif
+
+    std::vector<std::string> files; // by source string number, files[0] is the stage itself
+    std::string legend;
+    bool ok = false;                // false if a file or #include could not be read
+
+    // defines are "NAME" or "NAME=VALUE"
+    static ShaderSource load(const std::string& name, const std::vector<std::string>& defines)
+    {
+        ShaderSource source;
+        for (const std::string& define : defines) {
+            size_t equals = define.find('=');
+            if (equals == std::string::npos)
+                source.defineLines += "#define " + define + "\n";
+            else
+                source.defineLines += "#define " + define.substr(0, equals) + " " + define.substr(equals + 1) + "\n";
+        }
+        if (directory.empty())
+            source.ok = source.loadEmbedded(name);
+        else {
+            ShaderPreprocessor preprocessor;
+            source.ok = preprocessor.process(directory + "/" + name, source.text);
+            source.files = preprocessor.files;
+            source.legend = preprocessor.legend();
+        }
+        // the preprocessor puts a #line right after #version, so the defines
+        // can go in between without shifting line numbers
+        size_t version = source.data().find("#version");
+        size_t end = version == std::string_view::npos ? version : source.data().find('\n', version);
+        source.versionEnd = end == std::string_view::npos ? 0 : end + 1;
+        return source;
+    }
+
+    // the expanded source without the defines
+    std::string_view data() const
+    {
+        return embedded ? std::string_view(embedded, embeddedLength) : std::string_view(text);
+    }
+
+    // what glShaderSource gets: the #version line, the defines, the rest
+    static constexpr int PARTS = 3;
+    void parts(const char* strings[PARTS], int lengths[PARTS]) const
+    {
+        std::string_view code = data();
+        strings[0] = code.data();
+        lengths[0] = (int)versionEnd;
+        strings[1] = defineLines.data();
+        lengths[1] = (int)defineLines.size();
+        strings[2] = code.data() + versionEnd;
+        lengths[2] = (int)(code.size() - versionEnd);
+    }
+
+private:
+    std::string text;               // preprocessed from disk
+    const char* embedded = nullptr; // or the copy in the executable
+    size_t embeddedLength = 0;
+    size_t versionEnd = 0;
+    std::string defineLines;
+
+    bool loadEmbedded(const std::string& name)
+    {
+#ifdef SHELL_EMBEDDED_SHADERS
+        for (const EmbeddedShader& shader : embeddedShaders) {
+            if (name != shader.name)
+                continue;
+            embedded = shader.source;
+            embeddedLength = shader.length;
+            std::istringstream list(shader.files);
+            std::string file;
+            while (std::getline(list, file)) {
+                legend += (files.empty() ? "" : ", ") + std::to_string(files.size()) + " = " + file;
+                files.push_back(file);
+            }
+            return true;
+        }
+#endif
+        std::cout << "ERROR::SHADER::NOT_EMBEDDED " << name << std::endl;
+        return false;
+    }
+};
+#endif
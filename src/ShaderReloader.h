@@ -0,0 +1,287 @@
+#ifndef SHADER_RELOADER_H
+#define SHADER_RELOADER_H
+
+#include "Shader.h"
+#include "ParallelShaderCompile.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Rebuilds shaders while the app runs whenever one of their files is saved,
+// for shaders read from ShaderSource::directory rather than embedded ones.
+// A watcher thread waits on inotify for writes to .vert/.frag/.glsl files
+// and preprocesses the affected programs right there, so the render thread
+// never touches the disk. update() then submits the new sources (see
+// Shader's async constructor) and, once one has linked, swaps it in between
+// two frames. A program that fails to compile is dropped and the old one
+// stays in use. Linux only, start() reports false elsewhere.
+class ShaderReloader {
+public:
+    // render thread, right after a swap: resolve handles, bind blocks again
+    typedef std::function<void(Shader&)> SwapCallback;
+
+    int swaps = 0;
+    int failures = 0;
+
+    ShaderReloader() = default;
+    ShaderReloader(const ShaderReloader&) = delete;
+    ShaderReloader& operator=(const ShaderReloader&) = delete;
+
+    ~ShaderReloader()
+    {
+        stop();
+    }
+
+    // before start(). shader has to stay at the same address while watched
+    void watch(Shader& shader, const std::string& vertexName, const std::string& fragmentName,
+               const std::vector<std::string>& defines, SwapCallback onSwap)
+    {
+        Entry entry;
+        entry.shader = &shader;
+        entry.vertexName = vertexName;
+        entry.fragmentName = fragmentName;
+        entry.defines = defines;
+        entry.onSwap = onSwap;
+        entry.name = fragmentName;
+        for (const std::string& define : defines)
+            entry.name += " " + define;
+        entry.files = canonicalFiles(shader.files());
+        entries.push_back(std::move(entry));
+    }
+
+    bool start()
+    {
+        if (ShaderSource::directory.empty()) {
+            std::cout << "Shader reload: shaders are embedded, pass --shader-dir to reload them from disk" << std::endl;
+            return false;
+        }
+#ifdef __linux__
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) {
+            std::cout << "ERROR::SHADER_RELOADER::INOTIFY_INIT_FAILED" << std::endl;
+            return false;
+        }
+        for (const Entry& entry : entries)
+            watchDirectories(entry.files);
+        running.store(true, std::memory_order_release);
+        watcher = std::thread(&ShaderReloader::watchLoop, this);
+        std::cout << "Shader reload: watching " << directories.size() << " directories" << std::endl;
+        return true;
+#else
+        std::cout << "Shader reload: needs inotify, only available on Linux" << std::endl;
+        return false;
+#endif
+    }
+
+    bool isRunning() const { return watcher.joinable(); }
+
+    void stop()
+    {
+        if (!isRunning())
+            return;
+        running.store(false, std::memory_order_release);
+        watcher.join();
+#ifdef __linux__
+        close(fd);
+        fd = -1;
+#endif
+        for (Entry& entry : entries) {
+            if (entry.pending)
+                entry.pending->destroy();
+            entry.pending.reset();
+        }
+    }
+
+    // render thread, once per frame before anything is drawn
+    void update()
+    {
+        if (!isRunning())
+            return;
+        std::vector<Rebuilt> rebuilt;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            rebuilt.swap(finished);
+        }
+        for (Rebuilt& result : rebuilt) {
+            Entry& entry = entries[result.entry];
+            if (!result.vertex.ok || !result.fragment.ok) {
+                std::cout << "Shader reload: could not read " << entry.name << ", keeping the old program" << std::endl;
+                failures++;
+                continue;
+            }
+            if (entry.pending) // edited again before the last edit finished compiling
+                entry.pending->destroy();
+            entry.pending.reset(new Shader(result.vertex, result.fragment, entry.defines, true));
+            entry.submitted = std::chrono::steady_clock::now();
+        }
+
+        // without parallel_shader_compile every ready() blocks, so one per frame
+        bool waited = false;
+        for (Entry& entry : entries) {
+            if (!entry.pending || (waited && !ParallelShaderCompile::available))
+                continue;
+            waited = entry.pending->isPending();
+            if (!entry.pending->ready())
+                continue;
+            if (entry.pending->linked()) {
+                entry.shader->replaceWith(std::move(*entry.pending));
+                entry.onSwap(*entry.shader);
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - entry.submitted).count();
+                std::cout << "Shader reload: " << entry.name << " swapped in (" << ms << " ms)" << std::endl;
+                swaps++;
+            } else {
+                std::cout << "Shader reload: " << entry.name << " failed, keeping the old program" << std::endl;
+                entry.pending->destroy();
+                failures++;
+            }
+            entry.pending.reset();
+        }
+    }
+
+private:
+    // how long the files have to stay quiet before rebuilding, editors often
+    // write a file in several steps
+    static constexpr int SETTLE_MS = 50;
+
+    struct Entry {
+        Shader* shader = nullptr;
+        std::string vertexName, fragmentName; // see ShaderSource
+        std::vector<std::string> defines;
+        SwapCallback onSwap;
+        std::string name;                // for messages
+        std::set<std::string> files;     // canonical, watcher thread only once started
+        std::unique_ptr<Shader> pending; // render thread only
+        std::chrono::steady_clock::time_point submitted;
+    };
+    // sources the watcher thread preprocessed for entries[entry]
+    struct Rebuilt {
+        size_t entry;
+        ShaderSource vertex, fragment;
+    };
+
+    std::vector<Entry> entries;
+    std::mutex mutex;
+    std::vector<Rebuilt> finished;        // guarded by mutex
+    std::atomic<bool> running{false};
+    std::thread watcher;
+    int fd = -1;
+    std::map<int, std::string> directories; // watch descriptor to canonical directory
+
+    static std::string canonical(const std::string& path)
+    {
+        std::error_code error;
+        std::string result = std::filesystem::weakly_canonical(path, error).string();
+        return error ? path : result;
+    }
+    static std::set<std::string> canonicalFiles(const std::vector<std::string>& files)
+    {
+        std::set<std::string> result;
+        for (const std::string& file : files)
+            result.insert(canonical(file));
+        return result;
+    }
+    static bool isShaderFile(const std::string& path)
+    {
+        std::string extension = std::filesystem::path(path).extension().string();
+        return extension == ".vert" || extension == ".frag" || extension == ".glsl";
+    }
+
+    // directories rather than files, since editors that save by renaming a
+    // new file over the old one would end a watch on the file itself
+    void watchDirectories(const std::set<std::string>& files)
+    {
+#ifdef __linux__
+        for (const std::string& file : files) {
+            std::string directory = std::filesystem::path(file).parent_path().string();
+            int wd = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+            if (wd < 0)
+                std::cout << "ERROR::SHADER_RELOADER::COULD_NOT_WATCH " << directory << std::endl;
+            else
+                directories[wd] = directory;
+        }
+#endif
+    }
+
+    void watchLoop()
+    {
+#ifdef __linux__
+        Profiler::setThreadName("shader reload");
+        std::set<std::string> changed;
+        alignas(inotify_event) char buffer[4096];
+        while (running.load(std::memory_order_acquire)) {
+            // short waits so stop() is noticed, and the settle time once
+            // something changed
+            pollfd descriptor = { fd, POLLIN, 0 };
+            int count = poll(&descriptor, 1, changed.empty() ? 100 : SETTLE_MS);
+            if (count > 0) {
+                ssize_t length;
+                while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+                    for (char* at = buffer; at < buffer + length;) {
+                        const inotify_event* event = (const inotify_event*)at;
+                        at += sizeof(inotify_event) + event->len;
+                        auto directory = directories.find(event->wd);
+                        if (event->len == 0 || directory == directories.end())
+                            continue;
+                        std::string path = directory->second + "/" + event->name;
+                        if (isShaderFile(path))
+                            changed.insert(path);
+                    }
+                }
+                continue;
+            }
+            if (count == 0 && !changed.empty()) {
+                rebuild(changed);
+                changed.clear();
+            }
+        }
+#endif
+    }
+
+    // watcher thread: preprocesses every entry that uses one of the files
+    void rebuild(const std::set<std::string>& changed)
+    {
+        PROFILE_SCOPE("ShaderReloader::rebuild");
+        for (size_t i = 0; i < entries.size(); i++) {
+            Entry& entry = entries[i];
+            bool affected = false;
+            for (const std::string& file : changed)
+                affected = affected || entry.files.count(file) > 0;
+            if (!affected)
+                continue;
+            Rebuilt result = { i, ShaderSource::load(entry.vertexName, entry.defines),
+                               ShaderSource::load(entry.fragmentName, entry.defines) };
+            // an edit may have added includes
+            std::vector<std::string> files = result.vertex.files;
+            files.insert(files.end(), result.fragment.files.begin(), result.fragment.files.end());
+            entry.files = canonicalFiles(files);
+            watchDirectories(entry.files);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            for (Rebuilt& older : finished) {
+                if (older.entry == i) { // never picked up, replace it
+                    older = std::move(result);
+                    affected = false;
+                }
+            }
+            if (affected)
+                finished.push_back(std::move(result));
+        }
+    }
+};
+#endif
@@ -0,0 +1,174 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include "Shader.h"
+#include "ShaderReloader.h"
+#include "UniformBlocks.h"
+#include "VertexLayout.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// per-draw uniforms, resolved once after linking (see Shader::uniform).
+// Everything shared between programs lives in the blocks of UniformBlocks.h
+struct ShellUniforms {
+    UniformHandle model, instanceOffset;
+    VertexDecodeUniforms decode;
+
+    void resolve(const Shader& shader) {
+        model = shader.uniform("model");
+        instanceOffset = shader.uniform("uInstanceOffset");
+        decode.resolve(shader);
+    }
+};
+
+// lighting models compiled into basic.frag
+enum LightingModel {
+    LIGHTING_WRAP,  // wrapped Lambert on the directional light
+    LIGHTING_PHONG, // directional + point lights
+    LIGHTING_MODEL_COUNT
+};
+
+// Permutations of basic.vert/basic.frag, each compiled with only the code its
+// draws run instead of branching per fragment: the opaque base layer or the
+// shells, with or without the flashlight, per lighting model. The base layer
+// never sees the flashlight, so it has no flashlight permutation.
+//
+// All permutations are submitted at once and compile in the background
+// (see ParallelShaderCompile). build() only waits for the ones the first
+// frame needs; until another one is ready, base() and shells() hand out
+// those instead, so switching lighting or the flashlight never stalls a frame.
+class FurShaderVariants {
+public:
+    struct Variant {
+        std::unique_ptr<Shader> shader;
+        ShellUniforms uniforms;
+        bool prepared = false; // linked and set up, safe to draw with
+    };
+
+    void build(const char* vertexName, const char* fragmentName, LightingModel lighting, bool flashlight)
+    {
+        PROFILE_SCOPE("FurShaderVariants::build");
+        this->vertexName = vertexName;
+        this->fragmentName = fragmentName;
+        variants.clear();
+        variants.resize(2 * 2 * LIGHTING_MODEL_COUNT);
+        for (int l = 0; l < LIGHTING_MODEL_COUNT; l++) {
+            for (int f = 0; f < 2; f++) {
+                for (int b = 0; b < 2; b++) {
+                    if (b && f)
+                        continue;
+                    Variant& variant = variants[index(b, f, (LightingModel)l)];
+                    variant.shader.reset(new Shader(vertexName, fragmentName,
+                                                    defines(b, f, (LightingModel)l), true));
+                }
+            }
+        }
+        fallbackBase = index(true, false, lighting);
+        fallbackShells = index(false, flashlight, lighting);
+        prepare(variants[fallbackBase]);
+        prepare(variants[fallbackShells]);
+        startFrames = 0;
+        startTime = std::chrono::steady_clock::now();
+        announced = false;
+    }
+
+    // once per frame, sets up the permutations that finished compiling.
+    // Without parallel_shader_compile each one blocks, so only one per frame
+    void poll()
+    {
+        if (announced)
+            return;
+        startFrames++;
+        bool done = true;
+        bool waited = false;
+        for (Variant& variant : variants) {
+            if (!variant.shader || variant.prepared)
+                continue;
+            if (!ParallelShaderCompile::available && waited) {
+                done = false;
+                continue;
+            }
+            waited = variant.shader->isPending();
+            if (variant.shader->ready())
+                prepare(variant);
+            else
+                done = false;
+        }
+        if (done) {
+            announced = true;
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+            std::cout << "Shader variants: all ready after " << startFrames << " frames (" << ms << " ms)" << std::endl;
+        }
+    }
+
+    // rebuild every permutation when basic.vert/basic.frag or an include changes
+    void watch(ShaderReloader& reloader)
+    {
+        for (int l = 0; l < LIGHTING_MODEL_COUNT; l++) {
+            for (int f = 0; f < 2; f++) {
+                for (int b = 0; b < 2; b++) {
+                    if (b && f)
+                        continue;
+                    Variant& variant = variants[index(b, f, (LightingModel)l)];
+                    reloader.watch(*variant.shader, vertexName, fragmentName, defines(b, f, (LightingModel)l),
+                                   [this, &variant](Shader&) { prepare(variant); });
+                }
+            }
+        }
+    }
+
+    // the requested permutation, or the startup one while it is still compiling
+    Variant& base(LightingModel lighting)
+    {
+        return pick(index(true, false, lighting), fallbackBase);
+    }
+    Variant& shells(bool flashlight, LightingModel lighting)
+    {
+        return pick(index(false, flashlight, lighting), fallbackShells);
+    }
+
+    static std::vector<std::string> defines(bool base, bool flashlight, LightingModel lighting)
+    {
+        std::vector<std::string> list;
+        if (base)
+            list.push_back("BASE_LAYER");
+        if (flashlight)
+            list.push_back("FLASHLIGHT");
+        if (lighting == LIGHTING_PHONG)
+            list.push_back("LIGHTING_PHONG");
+        return list;
+    }
+
+private:
+    std::vector<Variant> variants;
+    std::string vertexName, fragmentName;
+    int fallbackBase = 0, fallbackShells = 0;
+    int startFrames = 0;
+    std::chrono::steady_clock::time_point startTime;
+    bool announced = false;
+
+    void prepare(Variant& variant)
+    {
+        variant.shader->wait();
+        variant.uniforms.resolve(*variant.shader);
+        bindUniformBlocks(*variant.shader);
+        variant.prepared = true;
+    }
+    Variant& pick(int wanted, int fallback)
+    {
+        Variant& variant = variants[wanted];
+        if (variant.prepared && variant.shader->linked())
+            return variant;
+        return variants[fallback];
+    }
+
+    static int index(bool base, bool flashlight, LightingModel lighting)
+    {
+        return ((int)lighting * 2 + (int)flashlight) * 2 + (int)base;
+    }
+};
+#endif
@@ -0,0 +1,129 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "Benchmark.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// One point of the parameter grid
+struct SweepCell {
+    int numLayers;
+    float gridFreq;
+    float strandThickness;
+    int width;
+    int height;
+};
+
+// Grid of fur parameters x render resolutions, rendered cell by cell from a
+// fixed camera so cost can be read off as a surface instead of guessed.
+// Each cell renders warmupFrames + framesPerCell frames; only the latter are
+// recorded. Cells are ordered resolution first so the render target is only
+// recreated when the resolution actually changes.
+class ParameterSweep {
+public:
+    std::vector<int> layers = { 16, 32, 64, 128 };
+    std::vector<float> gridFreqs = { 500.0f, 1000.0f, 1500.0f, 2000.0f };
+    std::vector<float> thicknesses = { 0.6f, 0.75f, 0.9f };
+    std::vector<SweepCell> resolutions = {}; // only width/height are used
+    int warmupFrames = 10;
+    int framesPerCell = 30;
+
+    std::vector<SweepCell> cells;
+    std::vector<BenchmarkRecorder> results; // one per cell
+
+    void build(int defaultWidth, int defaultHeight)
+    {
+        if (resolutions.empty())
+            resolutions.push_back({ 0, 0.0f, 0.0f, defaultWidth, defaultHeight });
+        cells.clear();
+        for (const SweepCell& res : resolutions)
+            for (int l : layers)
+                for (float f : gridFreqs)
+                    for (float t : thicknesses)
+                        cells.push_back({ l, f, t, res.width, res.height });
+        results.assign(cells.size(), BenchmarkRecorder());
+    }
+
+    int framesPerCellTotal() const { return warmupFrames + framesPerCell; }
+    int totalFrames() const { return (int)cells.size() * framesPerCellTotal(); }
+
+    // cell a frame belongs to, and whether it is recorded
+    int cellOf(int frame) const { return frame / framesPerCellTotal(); }
+    bool isMeasured(int frame) const { return frame % framesPerCellTotal() >= warmupFrames; }
+
+    void addFrame(int frame, double cpu, double frameMs)
+    {
+        if (isMeasured(frame))
+            results[cellOf(frame)].addFrame(cpu, frameMs);
+    }
+    void addGpuFrame(int frame, double gpu, const std::vector<double>& passes)
+    {
+        if (isMeasured(frame))
+            results[cellOf(frame)].addGpuFrame(gpu, passes);
+    }
+
+    // parses "16,32,64" style lists, returns false on garbage
+    template <typename T>
+    static bool parseList(const std::string& text, std::vector<T>& values)
+    {
+        values.clear();
+        std::stringstream in(text);
+        std::string item;
+        while (std::getline(in, item, ',')) {
+            std::istringstream itemIn(item);
+            T value;
+            if (!(itemIn >> value))
+                return false;
+            values.push_back(value);
+        }
+        return !values.empty();
+    }
+
+    // "640x360,1280x720"
+    static bool parseResolutions(const std::string& text, std::vector<SweepCell>& values)
+    {
+        values.clear();
+        std::stringstream in(text);
+        std::string item;
+        while (std::getline(in, item, ',')) {
+            SweepCell cell = {};
+            if (sscanf(item.c_str(), "%dx%d", &cell.width, &cell.height) != 2 ||
+                cell.width <= 0 || cell.height <= 0)
+                return false;
+            values.push_back(cell);
+        }
+        return !values.empty();
+    }
+
+    // one row per cell, medians and p95 in milliseconds
+    bool writeCSV(const std::string& path) const
+    {
+        std::ofstream out(path);
+        if (!out) {
+            std::cout << "ERROR::SWEEP::COULD_NOT_OPEN " << path << std::endl;
+            return false;
+        }
+        out << "width,height,num_layers,grid_freq,strand_thickness,frames,"
+               "cpu_ms_p50,cpu_ms_p95,gpu_ms_p50,gpu_ms_p95,gpu_base_ms_p50,gpu_shells_ms_p50,frame_ms_p50\n";
+        for (size_t i = 0; i < cells.size(); i++) {
+            const SweepCell& c = cells[i];
+            const BenchmarkRecorder& r = results[i];
+            FrameTimeStats cpu = FrameTimeStats::compute(r.cpuMs);
+            FrameTimeStats gpu = FrameTimeStats::compute(r.gpuMs);
+            FrameTimeStats frame = FrameTimeStats::compute(r.frameMs);
+            double base = r.passMs.size() > 0 ? FrameTimeStats::compute(r.passMs[0]).p50 : 0.0;
+            double shells = r.passMs.size() > 1 ? FrameTimeStats::compute(r.passMs[1]).p50 : 0.0;
+            out << c.width << "," << c.height << "," << c.numLayers << "," << c.gridFreq << ","
+                << c.strandThickness << "," << r.frameMs.size() << ","
+                << cpu.p50 << "," << cpu.p95 << "," << gpu.p50 << "," << gpu.p95 << ","
+                << base << "," << shells << "," << frame.p50 << "\n";
+        }
+        return (bool)out;
+    }
+};
+#endif
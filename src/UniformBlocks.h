@@ -0,0 +1,173 @@
+#ifndef UNIFORM_BLOCKS_H
+#define UNIFORM_BLOCKS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+
+#include <cstddef>
+#include <cstring>
+
+// C++ mirrors of the std140 uniform blocks declared in shaders/*.vert|frag.
+// std140 puts a vec3 on a 16 byte boundary and rounds structs and array
+// elements up to 16 bytes, the padding members below spell that out and the
+// static_asserts catch a layout that drifted from the GLSL side.
+
+struct DirLightStd140 {
+    glm::vec3 direction;  float pad0;
+    glm::vec3 ambient;    float pad1;
+    glm::vec3 diffuse;    float pad2;
+    glm::vec3 specular;   float pad3;
+};
+static_assert(sizeof(DirLightStd140) == 64, "std140 DirLight is 64 bytes");
+
+struct PointLightStd140 {
+    glm::vec3 position;
+    float constant;
+    float linear;
+    float quadratic;
+    float pad0[2];
+    glm::vec3 ambient;    float pad1;
+    glm::vec3 diffuse;    float pad2;
+    glm::vec3 specular;   float pad3;
+};
+static_assert(offsetof(PointLightStd140, constant) == 12, "std140 PointLight.constant");
+static_assert(offsetof(PointLightStd140, ambient) == 32, "std140 PointLight.ambient");
+static_assert(offsetof(PointLightStd140, specular) == 64, "std140 PointLight.specular");
+static_assert(sizeof(PointLightStd140) == 80, "std140 PointLight array stride is 80 bytes");
+
+struct SpotLightStd140 {
+    glm::vec3 position;   float pad0;
+    glm::vec3 direction;
+    float constant;
+    float linear;
+    float quadratic;
+    float pad1[2];
+    glm::vec3 ambient;    float pad2;
+    glm::vec3 diffuse;    float pad3;
+    glm::vec3 specular;
+    float cutOff;
+    float outerCutOff;
+    int flashLightEnable;
+    float pad4[2];
+};
+static_assert(offsetof(SpotLightStd140, constant) == 28, "std140 SpotLight.constant");
+static_assert(offsetof(SpotLightStd140, ambient) == 48, "std140 SpotLight.ambient");
+static_assert(offsetof(SpotLightStd140, cutOff) == 92, "std140 SpotLight.cutOff");
+static_assert(offsetof(SpotLightStd140, flashLightEnable) == 100, "std140 SpotLight.FlashLightEnable");
+static_assert(sizeof(SpotLightStd140) == 112, "std140 SpotLight is 112 bytes");
+
+// uniform FrameBlock: camera and time, used by every shader that draws the fur
+struct FrameBlock {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec3 viewPos;
+    float currFrame;
+};
+static_assert(offsetof(FrameBlock, projection) == 64, "std140 FrameBlock.projection");
+static_assert(offsetof(FrameBlock, viewPos) == 128, "std140 FrameBlock.viewPos");
+static_assert(offsetof(FrameBlock, currFrame) == 140, "std140 FrameBlock.currFrame");
+static_assert(sizeof(FrameBlock) == 144, "std140 FrameBlock is 144 bytes");
+
+#define NR_POINT_LIGHTS 4 // must match basic.frag
+
+// uniform LightBlock
+struct LightBlock {
+    DirLightStd140 dirLight;
+    PointLightStd140 pointLights[NR_POINT_LIGHTS];
+    SpotLightStd140 spotLight;
+};
+static_assert(offsetof(LightBlock, pointLights) == 64, "std140 LightBlock.pointLights");
+static_assert(offsetof(LightBlock, spotLight) == 384, "std140 LightBlock.spotLight");
+static_assert(sizeof(LightBlock) == 496, "std140 LightBlock is 496 bytes");
+
+// uniform FurBlock: shell placement and strand pattern
+struct FurBlock {
+    glm::vec3 baseColor;
+    int numLayers;
+    glm::vec3 gravity;
+    float furLength;
+    glm::vec3 windDirection;
+    float strandThickness;
+    float gridFrequency;
+    float pad0[3];
+};
+static_assert(offsetof(FurBlock, numLayers) == 12, "std140 FurBlock.uNumLayers");
+static_assert(offsetof(FurBlock, furLength) == 28, "std140 FurBlock.uFurLength");
+static_assert(offsetof(FurBlock, strandThickness) == 44, "std140 FurBlock.uStrandThickness");
+static_assert(offsetof(FurBlock, gridFrequency) == 48, "std140 FurBlock.uGridFrequency");
+static_assert(sizeof(FurBlock) == 64, "std140 FurBlock is 64 bytes");
+
+// binding points, the same for every program so one buffer serves them all
+enum UniformBlockBinding {
+    FRAME_BLOCK_BINDING = 0,
+    LIGHT_BLOCK_BINDING = 1,
+    FUR_BLOCK_BINDING = 2,
+};
+
+// One uniform buffer holding a T, attached to a fixed binding point.
+// Fill data and call upload() once per frame. A copy of what the buffer
+// holds is kept, upload() only sends the bytes between the first and last
+// one that changed and skips the update when nothing did
+template <typename T>
+class UniformBuffer {
+public:
+    T data = {};
+    unsigned int ID = 0;
+
+    void create(unsigned int binding)
+    {
+        glGenBuffers(1, &ID);
+        glBindBuffer(GL_UNIFORM_BUFFER, ID);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(T), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, ID);
+    }
+
+    void upload()
+    {
+        static_assert(sizeof(T) % 4 == 0, "std140 blocks are made of 4 byte words");
+        const unsigned char* bytes = (const unsigned char*)&data;
+        size_t first = 0, last = sizeof(T);
+        if (uploaded) {
+            if (std::memcmp(&data, shadow, sizeof(T)) == 0) {
+                UniformUploadStats::elided++;
+                return;
+            }
+            // every std140 member is made of 4 byte words, compare a word at a time
+            while (std::memcmp(bytes + first, shadow + first, 4) == 0)
+                first += 4;
+            while (std::memcmp(bytes + last - 4, shadow + last - 4, 4) == 0)
+                last -= 4;
+        }
+        std::memcpy(shadow + first, bytes + first, last - first);
+        uploaded = true;
+        UniformUploadStats::issued++;
+
+        glBindBuffer(GL_UNIFORM_BUFFER, ID);
+        glBufferSubData(GL_UNIFORM_BUFFER, first, last - first, bytes + first);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    void destroy()
+    {
+        if (ID != 0)
+            glDeleteBuffers(1, &ID);
+        ID = 0;
+        uploaded = false;
+    }
+
+private:
+    unsigned char shadow[sizeof(T)];
+    bool uploaded = false;
+};
+
+// connects whichever of the blocks a program declares to the shared bindings
+inline void bindUniformBlocks(const Shader& shader)
+{
+    shader.bindUniformBlock("FrameBlock", FRAME_BLOCK_BINDING);
+    shader.bindUniformBlock("LightBlock", LIGHT_BLOCK_BINDING);
+    shader.bindUniformBlock("FurBlock", FUR_BLOCK_BINDING);
+}
+#endif
@@ -0,0 +1,399 @@
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define MAX_BONE_INFLUENCE 4
+
+// Everything a loader can produce for one vertex. Only used on the CPU: the
+// GPU gets the packed streams below, just the ones a pipeline reads
+struct Vertex {
+    glm::vec3 Position;     // position
+    glm::vec3 Normal;       // normal
+    glm::vec2 TexCoords;    // texCoords
+    glm::vec3 Tangent;      // tangent
+    glm::vec3 Bitangent;    // bitangent
+        // bone indexes which will influence this vertex
+        int m_BoneIDs[MAX_BONE_INFLUENCE];
+        // weights for each bone
+        float m_Weights[MAX_BONE_INFLUENCE];
+};
+
+// what the shell programs read, every layer fetches this again
+struct ShellVertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoords;
+};
+static_assert(sizeof(ShellVertex) == 32, "shell stream should stay 32 bytes");
+
+// the shell stream in half the size: position and UV as unorm16 within the
+// mesh bounds, the normal octahedral in two snorm16. basic.vert decodes it
+// with the mesh's VertexQuantization (see VertexDecodeUniforms)
+struct QuantizedShellVertex {
+    uint16_t position[3];
+    uint16_t pad;
+    int16_t normal[2];
+    uint16_t texCoords[2];
+};
+static_assert(sizeof(QuantizedShellVertex) == 16, "quantized shell stream should stay 16 bytes");
+
+// for normal mapping
+struct TangentVertex {
+    glm::vec3 tangent;
+    glm::vec3 bitangent;
+};
+static_assert(sizeof(TangentVertex) == 24, "tangent stream is tightly packed");
+
+// for skinning
+struct SkinVertex {
+    int boneIDs[MAX_BONE_INFLUENCE];
+    float weights[MAX_BONE_INFLUENCE];
+};
+static_assert(sizeof(SkinVertex) == 32, "skin stream is tightly packed");
+
+// one buffer each
+enum VertexStream {
+    STREAM_SHELL,
+    STREAM_SHELL_QUANTIZED, // instead of STREAM_SHELL, never both
+    STREAM_TANGENTS,
+    STREAM_SKINNING,
+    VERTEX_STREAM_COUNT
+};
+
+// the streams a pipeline's vertex shader reads
+enum VertexStreamMask : unsigned int {
+    STREAMS_SHELL = 1u << STREAM_SHELL,
+    STREAMS_SHELL_QUANTIZED = 1u << STREAM_SHELL_QUANTIZED,
+    STREAMS_NORMAL_MAPPED = STREAMS_SHELL | 1u << STREAM_TANGENTS,
+    STREAMS_SKINNED = STREAMS_NORMAL_MAPPED | 1u << STREAM_SKINNING,
+};
+
+// one attribute, as glVertexAttrib(I)Pointer gets it
+struct VertexAttribute {
+    unsigned int location;  // layout(location = N) in the shaders
+    int components;
+    GLenum type;
+    bool normalized;
+    bool integer;           // read as ivec, see glVertexAttribIPointer
+    size_t offset;
+};
+
+struct VertexStreamLayout {
+    const char* name;
+    GLsizei stride;
+    std::vector<VertexAttribute> attributes;
+};
+
+// shader locations are shared by all streams: 0-2 shell, 3-4 tangents, 5-6 skin
+inline const VertexStreamLayout& vertexStreamLayout(VertexStream stream)
+{
+    static const VertexStreamLayout layouts[VERTEX_STREAM_COUNT] = {
+        { "shell", sizeof(ShellVertex), {
+            { 0, 3, GL_FLOAT, false, false, offsetof(ShellVertex, position) },
+            { 1, 3, GL_FLOAT, false, false, offsetof(ShellVertex, normal) },
+            { 2, 2, GL_FLOAT, false, false, offsetof(ShellVertex, texCoords) },
+        } },
+        { "shell quantized", sizeof(QuantizedShellVertex), {
+            { 0, 3, GL_UNSIGNED_SHORT, true, false, offsetof(QuantizedShellVertex, position) },
+            { 1, 2, GL_SHORT, true, false, offsetof(QuantizedShellVertex, normal) },
+            { 2, 2, GL_UNSIGNED_SHORT, true, false, offsetof(QuantizedShellVertex, texCoords) },
+        } },
+        { "tangents", sizeof(TangentVertex), {
+            { 3, 3, GL_FLOAT, false, false, offsetof(TangentVertex, tangent) },
+            { 4, 3, GL_FLOAT, false, false, offsetof(TangentVertex, bitangent) },
+        } },
+        { "skin", sizeof(SkinVertex), {
+            { 5, MAX_BONE_INFLUENCE, GL_INT, false, true, offsetof(SkinVertex, boneIDs) },
+            { 6, MAX_BONE_INFLUENCE, GL_FLOAT, false, false, offsetof(SkinVertex, weights) },
+        } },
+    };
+    return layouts[stream];
+}
+
+// points the attributes of layout at the buffer bound to GL_ARRAY_BUFFER,
+// for the bound VAO
+inline void applyVertexStreamLayout(const VertexStreamLayout& layout)
+{
+    for (const VertexAttribute& attribute : layout.attributes) {
+        glEnableVertexAttribArray(attribute.location);
+        if (attribute.integer)
+            glVertexAttribIPointer(attribute.location, attribute.components, attribute.type, layout.stride,
+                                   (void*)attribute.offset);
+        else
+            glVertexAttribPointer(attribute.location, attribute.components, attribute.type,
+                                  attribute.normalized ? GL_TRUE : GL_FALSE, layout.stride, (void*)attribute.offset);
+    }
+}
+
+// Bounds a mesh's quantized stream is encoded against, and how far the
+// decoded vertices end up from the originals
+struct VertexQuantization {
+    glm::vec3 positionMin = glm::vec3(0.0f);
+    glm::vec3 positionExtent = glm::vec3(1.0f);
+    glm::vec2 uvMin = glm::vec2(0.0f);
+    glm::vec2 uvExtent = glm::vec2(1.0f);
+    // largest round trip errors, filled in by packVertexStream
+    float maxPositionError = 0.0f;   // object space units
+    float maxNormalErrorDegrees = 0.0f;
+    float maxUVError = 0.0f;
+
+    static VertexQuantization fromBounds(const std::vector<Vertex>& vertices)
+    {
+        VertexQuantization quantization;
+        if (vertices.empty())
+            return quantization;
+        glm::vec3 positionMax = vertices[0].Position;
+        glm::vec2 uvMax = vertices[0].TexCoords;
+        quantization.positionMin = positionMax;
+        quantization.uvMin = uvMax;
+        for (const Vertex& vertex : vertices) {
+            quantization.positionMin = glm::min(quantization.positionMin, vertex.Position);
+            positionMax = glm::max(positionMax, vertex.Position);
+            quantization.uvMin = glm::min(quantization.uvMin, vertex.TexCoords);
+            uvMax = glm::max(uvMax, vertex.TexCoords);
+        }
+        quantization.positionExtent = positionMax - quantization.positionMin;
+        quantization.uvExtent = uvMax - quantization.uvMin;
+        return quantization;
+    }
+
+    void report(const std::string& name, size_t vertexCount) const
+    {
+        std::cout << "Quantized " << name << ": " << vertexCount << " vertices, "
+                  << sizeof(QuantizedShellVertex) << " instead of " << sizeof(ShellVertex)
+                  << " bytes each, max error position " << maxPositionError
+                  << " (extent " << glm::length(positionExtent) << "), normal " << maxNormalErrorDegrees
+                  << " deg, uv " << maxUVError << std::endl;
+    }
+
+    static uint16_t toUnorm16(float value, float min, float extent)
+    {
+        float t = extent > 0.0f ? (value - min) / extent : 0.0f;
+        return (uint16_t)std::lround(std::clamp(t, 0.0f, 1.0f) * 65535.0f);
+    }
+    static float fromUnorm16(uint16_t value, float min, float extent)
+    {
+        return min + value / 65535.0f * extent;
+    }
+    static int16_t toSnorm16(float value)
+    {
+        return (int16_t)std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f);
+    }
+    static float fromSnorm16(int16_t value)
+    {
+        return std::max(value / 32767.0f, -1.0f);
+    }
+
+    // unit vector to the octahedron folded onto [-1, 1]^2, same as octDecode in basic.vert
+    static glm::vec2 octEncode(glm::vec3 n)
+    {
+        n /= std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        glm::vec2 f(n.x, n.y);
+        if (n.z < 0.0f)
+            f = (1.0f - glm::abs(glm::vec2(f.y, f.x))) * glm::vec2(f.x >= 0.0f ? 1.0f : -1.0f, f.y >= 0.0f ? 1.0f : -1.0f);
+        return f;
+    }
+    static glm::vec3 octDecode(glm::vec2 f)
+    {
+        glm::vec3 n(f.x, f.y, 1.0f - std::abs(f.x) - std::abs(f.y));
+        float t = std::max(-n.z, 0.0f);
+        n.x += n.x >= 0.0f ? -t : t;
+        n.y += n.y >= 0.0f ? -t : t;
+        return glm::normalize(n);
+    }
+
+    // what basic.vert reconstructs from a QuantizedShellVertex
+    glm::vec3 decodePosition(const QuantizedShellVertex& vertex) const
+    {
+        return glm::vec3(fromUnorm16(vertex.position[0], positionMin.x, positionExtent.x),
+                         fromUnorm16(vertex.position[1], positionMin.y, positionExtent.y),
+                         fromUnorm16(vertex.position[2], positionMin.z, positionExtent.z));
+    }
+    glm::vec3 decodeNormal(const QuantizedShellVertex& vertex) const
+    {
+        return octDecode(glm::vec2(fromSnorm16(vertex.normal[0]), fromSnorm16(vertex.normal[1])));
+    }
+};
+
+// one stream's data for all vertices, laid out as vertexStreamLayout(stream).
+// STREAM_SHELL_QUANTIZED needs the mesh's quantization, which gets the errors
+inline void packVertexStream(VertexStream stream, const std::vector<Vertex>& vertices, std::vector<unsigned char>& out,
+                             VertexQuantization* quantization = nullptr)
+{
+    out.resize(vertices.size() * vertexStreamLayout(stream).stride);
+    switch (stream) {
+    case STREAM_SHELL: {
+        ShellVertex* packed = (ShellVertex*)out.data();
+        for (size_t i = 0; i < vertices.size(); i++)
+            packed[i] = { vertices[i].Position, vertices[i].Normal, vertices[i].TexCoords };
+        break;
+    }
+    case STREAM_SHELL_QUANTIZED: {
+        QuantizedShellVertex* packed = (QuantizedShellVertex*)out.data();
+        VertexQuantization& q = *quantization;
+        for (size_t i = 0; i < vertices.size(); i++) {
+            const Vertex& vertex = vertices[i];
+            QuantizedShellVertex& v = packed[i];
+            glm::vec3 position;
+            for (int c = 0; c < 3; c++) {
+                v.position[c] = VertexQuantization::toUnorm16(vertex.Position[c], q.positionMin[c], q.positionExtent[c]);
+                position[c] = VertexQuantization::fromUnorm16(v.position[c], q.positionMin[c], q.positionExtent[c]);
+            }
+            v.pad = 0;
+            glm::vec2 oct = VertexQuantization::octEncode(vertex.Normal);
+            v.normal[0] = VertexQuantization::toSnorm16(oct.x);
+            v.normal[1] = VertexQuantization::toSnorm16(oct.y);
+            glm::vec3 normal = VertexQuantization::octDecode(glm::vec2(VertexQuantization::fromSnorm16(v.normal[0]),
+                                                                       VertexQuantization::fromSnorm16(v.normal[1])));
+            glm::vec2 uv;
+            for (int c = 0; c < 2; c++) {
+                v.texCoords[c] = VertexQuantization::toUnorm16(vertex.TexCoords[c], q.uvMin[c], q.uvExtent[c]);
+                uv[c] = VertexQuantization::fromUnorm16(v.texCoords[c], q.uvMin[c], q.uvExtent[c]);
+            }
+
+            float cosine = glm::clamp(glm::dot(normal, glm::normalize(vertex.Normal)), -1.0f, 1.0f);
+            q.maxPositionError = std::max(q.maxPositionError, glm::length(position - vertex.Position));
+            q.maxNormalErrorDegrees = std::max(q.maxNormalErrorDegrees, glm::degrees(std::acos(cosine)));
+            q.maxUVError = std::max(q.maxUVError, glm::length(uv - vertex.TexCoords));
+        }
+        break;
+    }
+    case STREAM_TANGENTS: {
+        TangentVertex* packed = (TangentVertex*)out.data();
+        for (size_t i = 0; i < vertices.size(); i++)
+            packed[i] = { vertices[i].Tangent, vertices[i].Bitangent };
+        break;
+    }
+    case STREAM_SKINNING: {
+        SkinVertex* packed = (SkinVertex*)out.data();
+        for (size_t i = 0; i < vertices.size(); i++) {
+            for (int j = 0; j < MAX_BONE_INFLUENCE; j++) {
+                packed[i].boneIDs[j] = vertices[i].m_BoneIDs[j];
+                packed[i].weights[j] = vertices[i].m_Weights[j];
+            }
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// A VAO with one buffer per requested stream plus the index buffer, the
+// attribute setup generated from the stream layouts
+class VertexBuffers {
+public:
+    unsigned int VAO = 0;
+    unsigned int streams = 0;  // VertexStreamMask that was uploaded
+    size_t vertexCount = 0;
+    GLsizei indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT; // GL_UNSIGNED_SHORT when every index fits
+    size_t bytesPerVertex = 0; // over all uploaded streams
+    VertexQuantization quantization; // with STREAMS_SHELL_QUANTIZED
+
+    bool quantized() const { return (streams & STREAMS_SHELL_QUANTIZED) != 0; }
+    unsigned int elementBuffer() const { return EBO; }
+
+    // video memory of the vertex streams and indices
+    size_t bytes() const
+    {
+        size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+        return vertexCount * bytesPerVertex + (size_t)indexCount * indexSize;
+    }
+
+    void upload(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, unsigned int streamMask)
+    {
+        if ((streamMask & STREAMS_SHELL) && (streamMask & STREAMS_SHELL_QUANTIZED)) {
+            std::cout << "ERROR::VERTEX_BUFFERS::BOTH_SHELL_STREAMS using the quantized one" << std::endl;
+            streamMask &= ~(unsigned int)STREAMS_SHELL;
+        }
+        streams = streamMask;
+        if (quantized())
+            quantization = VertexQuantization::fromBounds(vertices);
+        vertexCount = vertices.size();
+        indexCount = (GLsizei)indices.size();
+        bytesPerVertex = 0;
+
+        glGenVertexArrays(1, &VAO);
+        glBindVertexArray(VAO);
+        std::vector<unsigned char> packed;
+        for (int stream = 0; stream < VERTEX_STREAM_COUNT; stream++) {
+            if (!(streams & (1u << stream)))
+                continue;
+            const VertexStreamLayout& layout = vertexStreamLayout((VertexStream)stream);
+            packVertexStream((VertexStream)stream, vertices, packed, &quantization);
+            glGenBuffers(1, &buffers[stream]);
+            glBindBuffer(GL_ARRAY_BUFFER, buffers[stream]);
+            glBufferData(GL_ARRAY_BUFFER, packed.size(), packed.data(), GL_STATIC_DRAW);
+            applyVertexStreamLayout(layout);
+            bytesPerVertex += layout.stride;
+        }
+        glGenBuffers(1, &EBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        indexType = vertices.size() <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        if (indexType == GL_UNSIGNED_SHORT) {
+            std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(uint16_t), shortIndices.data(),
+                         GL_STATIC_DRAW);
+        } else
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void destroy()
+    {
+        glDeleteVertexArrays(1, &VAO);
+        for (unsigned int& buffer : buffers) {
+            if (buffer)
+                glDeleteBuffers(1, &buffer);
+            buffer = 0;
+        }
+        glDeleteBuffers(1, &EBO);
+        VAO = EBO = 0;
+    }
+
+private:
+    unsigned int buffers[VERTEX_STREAM_COUNT] = {};
+    unsigned int EBO = 0;
+};
+// the uniforms basic.vert decodes a quantized shell stream with, set for the
+// mesh about to be drawn. Meshes with the float stream only clear uQuantized
+struct VertexDecodeUniforms {
+    UniformHandle quantized, positionMin, positionExtent, uvMin, uvExtent;
+
+    void resolve(const Shader& shader)
+    {
+        quantized = shader.uniform("uQuantized");
+        positionMin = shader.uniform("uPositionMin");
+        positionExtent = shader.uniform("uPositionExtent");
+        uvMin = shader.uniform("uUVMin");
+        uvExtent = shader.uniform("uUVExtent");
+    }
+
+    void set(const Shader& shader, const VertexBuffers& buffers) const
+    {
+        shader.setBool(quantized, buffers.quantized());
+        if (!buffers.quantized())
+            return;
+        const VertexQuantization& q = buffers.quantization;
+        shader.setVec3(positionMin, q.positionMin);
+        shader.setVec3(positionExtent, q.positionExtent);
+        shader.setVec2(uvMin, q.uvMin);
+        shader.setVec2(uvExtent, q.uvExtent);
+    }
+};
+#endif
@@ -12,11 +12,34 @@
 #include "Camera.h"
 // #include "Model.h"
 #include "Mesh.h"
+#include "Headless.h"
+#include "Image.h"
+#include "Benchmark.h"
+#include "GpuTimer.h"
+#include "Profiler.h"
+#include "FillStats.h"
+#include "Geometry.h"
+#include "MeshOptimizer.h"
+#include "Meshlets.h"
+#include "MeshResidency.h"
+#include "GeometryArena.h"
+#include "FurPhysics.h"
+#include "Sweep.h"
+#include "FramePacing.h"
+#include "GLStats.h"
+#include "Golden.h"
+#include "UniformBlocks.h"
+#include "ShaderVariants.h"
+#include "ShaderReloader.h"
 
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
 
 
 /* ----------
@@ -25,6 +48,101 @@ To build use:
 - cmake --build . && ./OpenGlShell
 ---------- */
 
+/* ----------
+Headless (no window, renders into an FBO through surfaceless EGL):
+- ./OpenGlShell --headless --frames 300 --size 1280x720 --dump frames --dump-every 60
+  --frames N       number of frames to render before exiting (default 300)
+  --size WxH       render target size (default 800x600)
+  --dump DIR       write frames as PNG into DIR
+  --dump-every N   only dump every Nth frame (default 1)
+Runs under Mesa llvmpipe, e.g. LIBGL_ALWAYS_SOFTWARE=1 on GPU-less machines.
+---------- */
+
+/* ----------
+Benchmark (replays a camera path + fur parameter schedule on a fixed clock):
+- ./OpenGlShell --headless --benchmark --json results.json
+  --benchmark      run the built-in script (orbit while ramping layers/density)
+  --script FILE    run a script file instead, see BenchmarkScript for the format
+  --json FILE      where to write p50/p95/p99/max frame times (default benchmark.json)
+  --warmup N       frames rendered before recording starts (default 10)
+---------- */
+
+/* ----------
+Parameter sweep (headless, fixed camera, one CSV row per grid cell):
+- ./OpenGlShell --sweep --sweep-layers 16,32,64,128 --sweep-res 1280x720,1920x1080 --csv sweep.csv
+  --sweep              render every numLayers x gridFreq x strandThickness x resolution cell
+  --sweep-layers L,..  layer counts (default 16,32,64,128)
+  --sweep-freq F,..    grid frequencies (default 500,1000,1500,2000)
+  --sweep-thickness T,.. strand thicknesses (default 0.6,0.75,0.9)
+  --sweep-res WxH,..   render resolutions (default --size)
+  --sweep-frames N     recorded frames per cell (default 30), --warmup frames come first
+  --csv FILE           where to write CPU/GPU p50/p95 per cell (default sweep.csv)
+---------- */
+
+/* ----------
+Golden image regression (headless, exits with 1 when a scene no longer matches):
+- ./OpenGlShell --golden ../golden --size 160x120 --golden-update   (record, on a known-good build)
+- ./OpenGlShell --golden ../golden --size 160x120                   (compare)
+  --golden DIR           render every goldenScenes() view, compare against DIR/<scene>.png
+  --golden-update        write the renders as the new goldens instead
+  --golden-delta-e E     per pixel CIE76 delta E that counts as different (default 10)
+  --golden-tolerance P   percent of pixels allowed to differ (default 0.5)
+Failing scenes leave <scene>_actual.png and <scene>_diff.png next to the golden.
+---------- */
+
+/* ----------
+Profiling (CPU zones, open the file in chrome://tracing or ui.perfetto.dev):
+- ./OpenGlShell --trace trace.json
+Frame pacing (histogram, percentiles and hitches are printed on exit):
+- ./OpenGlShell --frame-log frames.bin
+  --frame-log FILE   binary per-frame log (dt, CPU, GPU, layers), see FrameLog
+GL call accounting (draws, uniforms, binds, state changes, redundant calls):
+- ./OpenGlShell --gl-stats
+---------- */
+
+/* ----------
+Fill rate diagnostics:
+- ./OpenGlShell --layer-stats layers.csv --overdraw wasted
+  --layer-stats FILE   count rasterized/surviving fragments per shell layer, CSV on exit
+  --overdraw MODE      show an additive heatmap instead of the fur,
+                       MODE is rasterized, wasted (discarded) or survived
+  H cycles the heatmap modes while running
+---------- */
+
+/* ----------
+Shader variants (basic.frag is compiled once per base/shell x flashlight x lighting model):
+  --lighting MODEL     wrap (wrapped Lambert, default) or phong (directional + point lights)
+  --flashlight         start with the flashlight on
+  L cycles the lighting model and F toggles the flashlight while running
+  --quantize-vertices  upload the sphere as 16 bit positions/UVs and octahedral
+                       normals (16 instead of 32 bytes), prints the error
+  --no-mesh-optimize   keep the sphere's triangles in generation order
+                       (see MeshOptimizer, the ACMR it reaches is printed)
+  --no-meshlet-cull    draw every meshlet of the sphere, including the back
+                       facing ones (see Meshlets)
+  --mesh-residency R   what the sphere keeps in system memory after upload:
+                       discard (default, nothing reads it), quantized or full.
+                       Prints the memory each costs (see MeshResidency.h)
+---------- */
+
+/* ----------
+Shader program cache (linked programs are reused across runs on the same driver):
+  --shader-cache DIR   where to keep program binaries (default shader_cache)
+  --no-shader-cache    always compile from source
+Hits, misses and the startup time saved are printed after loading shaders.
+---------- */
+
+/* ----------
+Shader sources are compiled into the executable, with #includes expanded:
+  --shader-dir DIR     read them from DIR instead, e.g. ../shaders
+Shader hot reload (Linux, needs --shader-dir; on by default in the window,
+off for headless runs):
+- ./OpenGlShell --shader-dir ../shaders     then edit and save shaders/basic.frag
+  --hot-reload         also watch shaders in headless runs
+  --no-hot-reload      don't watch the shader files
+A shader that fails to compile prints its errors and the old one stays in use.
+---------- */
+
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 Camera debugCam;
 
@@ -36,15 +154,65 @@ float lastFrame = 0.0f;
 
 bool useDebugCam = false; // bool for debug perspective
 bool flashlightOn = false; // bool for flashlight
+int lightingModel = LIGHTING_WRAP; // basic.frag variant, see FurShaderVariants
 bool uiMode = false; // for tabbing out
 
+// overdraw heatmap shown instead of the fur, matches uChannel in heatmap.frag
+enum OverdrawMode {
+    OVERDRAW_OFF,
+    OVERDRAW_RASTERIZED, // every fragment the shells rasterize
+    OVERDRAW_WASTED,     // fragments basic.frag discards
+    OVERDRAW_SURVIVED,   // fragments that end up drawn
+    OVERDRAW_MODE_COUNT
+};
+int overdrawMode = OVERDRAW_OFF;
+
 int numLayers = 80; // instances/layers of hair
 float gridFreq = 1500.0f; // hair frequency on object
 float strandThickness = 0.9f; // thickness of hair
-float furLength = 0.25f; // length of strands
-
-glm::vec3 lastCameraPos = glm::vec3(0.0f); // allows for velocity calculation
-glm::vec3 furWindDirection = glm::vec3(0.0f); // used for hair physics
+float furLength = 0.15f; // length of strands
+
+// command line options, see parseArgs
+struct AppOptions {
+    bool headless = false;
+    int frames = 300;          // frames to render in headless mode
+    int width = SCR_WIDTH;
+    int height = SCR_HEIGHT;
+    std::string dumpDir;       // empty disables PNG dumps
+    int dumpEvery = 1;
+    bool benchmark = false;
+    std::string scriptPath;    // empty uses BenchmarkScript::makeDefault
+    std::string jsonPath = "benchmark.json";
+    int warmupFrames = 10;
+    std::string tracePath;     // empty leaves the profiler off
+    std::string layerStatsPath; // empty disables per-layer fragment counting
+    bool sweep = false;
+    ParameterSweep sweepGrid;
+    std::string csvPath = "sweep.csv";
+    std::string frameLogPath;  // empty disables the binary frame log
+    bool glStats = false;      // count GL calls through GLStats
+    std::string goldenDir;     // empty disables golden image checks
+    bool goldenUpdate = false;
+    GoldenCompare goldenCompare;
+    std::string shaderCacheDir = "shader_cache"; // empty compiles every shader from source
+    bool quantizeVertices = false; // 16 instead of 32 bytes per sphere vertex
+    bool optimizeMeshes = true;    // reorder the sphere for the vertex cache, see MeshOptimizer
+    bool cullMeshlets = true;      // skip back facing and off screen parts of the sphere, see Meshlets
+    MeshResidency meshResidency = RESIDENCY_DISCARD; // the sphere's CPU data after upload
+    int hotReload = -1;        // rebuild shaders when their files change, -1 means only with a window
+                               // and --shader-dir
+};
+
+// passes timed by GpuTimer
+enum RenderPass {
+    PASS_BASE,   // opaque base layer (instance 0)
+    PASS_SHELLS, // blended shell layers (instances 1..numLayers-1)
+};
+
+// fixed simulation step for headless and benchmark runs so output is deterministic
+const float HEADLESS_DT = 1.0f / 60.0f;
+
+FurPhysics furPhysics;
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
     // Allows better scaling to Window Change
@@ -73,6 +241,7 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
 }
 
 unsigned int loadTexture(const char* path) {
+    PROFILE_SCOPE("loadTexture");
     unsigned int textureID;
     glGenTextures(1, &textureID);
 
@@ -107,9 +276,12 @@ unsigned int loadTexture(const char* path) {
 }
 
 void processInput(GLFWwindow *window, Camera& camera, float deltaTime){
+    PROFILE_SCOPE("processInput");
     static bool fWasPressed = false;
     static bool pWasPressed = false;
     static bool oWasPressed = false;
+    static bool hWasPressed = false;
+    static bool lWasPressed = false;
 
     // closes window
     if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
@@ -160,6 +332,20 @@ void processInput(GLFWwindow *window, Camera& camera, float deltaTime){
     }
     fWasPressed = fPressed;
 
+    // Overdraw heatmap (off -> rasterized -> wasted -> survived)
+    bool hPressed = glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS;
+    if(hPressed && !hWasPressed) {
+        overdrawMode = (overdrawMode + 1) % OVERDRAW_MODE_COUNT;
+    }
+    hWasPressed = hPressed;
+
+    // Lighting model (wrapped Lambert -> Phong), switches shader variants
+    bool lPressed = glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS;
+    if(lPressed && !lWasPressed) {
+        lightingModel = (lightingModel + 1) % LIGHTING_MODEL_COUNT;
+    }
+    lWasPressed = lPressed;
+
     // Debug Camera Switch
     bool pPressed = glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS;
     if(pPressed && !pWasPressed) {
@@ -197,111 +383,297 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
 }
 
 void updateFurPhysics(Camera& cam, float deltaTime) {
-    // calculate velocity based on camera position
-    glm::vec3 velocity = (cam.Position - lastCameraPos) / deltaTime;
-    lastCameraPos = cam.Position;
-
-    // smooths the wind direction
-    float smoothing = 0.9f;
-    glm::vec3 targetWind = -velocity;
-    furWindDirection = glm::mix(targetWind, furWindDirection, smoothing);
-
-    // Clamp maximum strength
-    float maxWindStrength = 2.0f;
-    if(glm::length(furWindDirection) > maxWindStrength) {
-        furWindDirection = glm::normalize(furWindDirection) * maxWindStrength;
+    furPhysics.update(cam.Position, deltaTime);
+}
+
+bool parseArgs(int argc, char** argv, AppOptions& opts) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--headless")
+            opts.headless = true;
+        else if (arg == "--frames" && hasValue)
+            opts.frames = std::max(1, atoi(argv[++i]));
+        else if (arg == "--size" && hasValue) {
+            if (sscanf(argv[++i], "%dx%d", &opts.width, &opts.height) != 2 ||
+                opts.width <= 0 || opts.height <= 0) {
+                std::cout << "Invalid --size, expected WxH" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--dump" && hasValue)
+            opts.dumpDir = argv[++i];
+        else if (arg == "--dump-every" && hasValue)
+            opts.dumpEvery = std::max(1, atoi(argv[++i]));
+        else if (arg == "--benchmark")
+            opts.benchmark = true;
+        else if (arg == "--script" && hasValue) {
+            opts.benchmark = true;
+            opts.scriptPath = argv[++i];
+        }
+        else if (arg == "--json" && hasValue)
+            opts.jsonPath = argv[++i];
+        else if (arg == "--warmup" && hasValue)
+            opts.warmupFrames = std::max(0, atoi(argv[++i]));
+        else if (arg == "--trace" && hasValue)
+            opts.tracePath = argv[++i];
+        else if (arg == "--golden" && hasValue) {
+            opts.goldenDir = argv[++i];
+            opts.headless = true;
+        }
+        else if (arg == "--golden-update")
+            opts.goldenUpdate = true;
+        else if (arg == "--golden-delta-e" && hasValue)
+            opts.goldenCompare.deltaEThreshold = atof(argv[++i]);
+        else if (arg == "--golden-tolerance" && hasValue)
+            opts.goldenCompare.maxFailedPct = atof(argv[++i]);
+        else if (arg == "--gl-stats")
+            opts.glStats = true;
+        else if (arg == "--shader-cache" && hasValue)
+            opts.shaderCacheDir = argv[++i];
+        else if (arg == "--no-shader-cache")
+            opts.shaderCacheDir.clear();
+        else if (arg == "--shader-dir" && hasValue)
+            ShaderSource::directory = argv[++i];
+        else if (arg == "--hot-reload")
+            opts.hotReload = 1;
+        else if (arg == "--no-hot-reload")
+            opts.hotReload = 0;
+        else if (arg == "--frame-log" && hasValue)
+            opts.frameLogPath = argv[++i];
+        else if (arg == "--layer-stats" && hasValue)
+            opts.layerStatsPath = argv[++i];
+        else if (arg == "--sweep")
+            opts.sweep = opts.headless = true;
+        else if (arg == "--sweep-layers" && hasValue) {
+            if (!ParameterSweep::parseList(argv[++i], opts.sweepGrid.layers)) {
+                std::cout << "Invalid --sweep-layers, expected a list like 16,32,64" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--sweep-freq" && hasValue) {
+            if (!ParameterSweep::parseList(argv[++i], opts.sweepGrid.gridFreqs)) {
+                std::cout << "Invalid --sweep-freq, expected a list like 500,1000" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--sweep-thickness" && hasValue) {
+            if (!ParameterSweep::parseList(argv[++i], opts.sweepGrid.thicknesses)) {
+                std::cout << "Invalid --sweep-thickness, expected a list like 0.6,0.9" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--sweep-res" && hasValue) {
+            if (!ParameterSweep::parseResolutions(argv[++i], opts.sweepGrid.resolutions)) {
+                std::cout << "Invalid --sweep-res, expected a list like 1280x720,1920x1080" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--sweep-frames" && hasValue)
+            opts.sweepGrid.framesPerCell = std::max(1, atoi(argv[++i]));
+        else if (arg == "--csv" && hasValue)
+            opts.csvPath = argv[++i];
+        else if (arg == "--overdraw" && hasValue) {
+            std::string mode = argv[++i];
+            if (mode == "rasterized") overdrawMode = OVERDRAW_RASTERIZED;
+            else if (mode == "wasted") overdrawMode = OVERDRAW_WASTED;
+            else if (mode == "survived") overdrawMode = OVERDRAW_SURVIVED;
+            else {
+                std::cout << "Invalid --overdraw, expected rasterized, wasted or survived" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--lighting" && hasValue) {
+            std::string model = argv[++i];
+            if (model == "wrap") lightingModel = LIGHTING_WRAP;
+            else if (model == "phong") lightingModel = LIGHTING_PHONG;
+            else {
+                std::cout << "Invalid --lighting, expected wrap or phong" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--flashlight")
+            flashlightOn = true;
+        else if (arg == "--quantize-vertices")
+            opts.quantizeVertices = true;
+        else if (arg == "--no-mesh-optimize")
+            opts.optimizeMeshes = false;
+        else if (arg == "--no-meshlet-cull")
+            opts.cullMeshlets = false;
+        else if (arg == "--mesh-residency" && hasValue) {
+            if (!parseMeshResidency(argv[++i], opts.meshResidency)) {
+                std::cout << "Invalid --mesh-residency, expected full, quantized or discard" << std::endl;
+                return false;
+            }
+        }
+        else {
+            std::cout << "Unknown argument: " << arg << std::endl;
+            return false;
+        }
     }
+    return true;
 }
 
-int main() {
-    // Calls intialization in the if statement
-    if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW\n";
+int main(int argc, char** argv) {
+    AppOptions opts;
+    if (!parseArgs(argc, argv, opts))
+        return -1;
+
+    Profiler::enabled = !opts.tracePath.empty();
+    Profiler::setThreadName("main");
+    ProfileScope startupZone("startup");
+
+    bool golden = !opts.goldenDir.empty();
+    if ((int)opts.sweep + (int)opts.benchmark + (int)golden > 1) {
+        std::cout << "--sweep, --benchmark and --golden can't be combined" << std::endl;
         return -1;
     }
-    // Request an OpenGL 3.3 core profile context
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    std::vector<GoldenScene> scenes = goldenScenes();
+    int goldenFailures = 0;
+    if (opts.sweep) {
+        opts.sweepGrid.warmupFrames = opts.warmupFrames;
+        opts.sweepGrid.build(opts.width, opts.height);
+        // start at the first cell's size so the first cell doesn't recreate it
+        opts.width = opts.sweepGrid.cells[0].width;
+        opts.height = opts.sweepGrid.cells[0].height;
+        std::cout << "Sweep: " << opts.sweepGrid.cells.size() << " cells, "
+                  << opts.sweepGrid.totalFrames() << " frames" << std::endl;
+    }
+
+    BenchmarkScript script = BenchmarkScript::makeDefault();
+    if (!opts.scriptPath.empty() && !script.loadFromFile(opts.scriptPath))
+        return -1;
+
+    GLFWwindow* window = nullptr;
+    HeadlessContext headless; // only initialized with --headless
+    RenderTarget offscreen;   // stands in for the window in headless mode
+
+    ProfileScope contextZone("create context");
+    if (opts.headless) {
+        if (!headless.init()) {
+            std::cout << "Failed to create headless context" << std::endl;
+            return -1;
+        }
+        if (!gladLoadGLLoader((GLADloadproc)HeadlessContext::getProcAddress)) {
+            std::cout << "Failed to initialize GLAD" << std::endl;
+            return -1;
+        }
+        ProgramCache::init((GLADloadproc)HeadlessContext::getProcAddress, opts.shaderCacheDir);
+        ParallelShaderCompile::init((GLADloadproc)HeadlessContext::getProcAddress);
+        GeometryArena::init((GLADloadproc)HeadlessContext::getProcAddress);
+        std::cout << "Headless renderer: " << glGetString(GL_RENDERER) << std::endl;
+        if (!offscreen.create(opts.width, opts.height))
+            return -1;
+        if (!opts.dumpDir.empty())
+            std::filesystem::create_directories(opts.dumpDir);
+    } else {
+        // Calls intialization in the if statement
+        if (!glfwInit()) {
+            std::cerr << "Failed to initialize GLFW\n";
+            return -1;
+        }
+        // Request an OpenGL 3.3 core profile context
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 #ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 // --------------------------
-    // Create a windowed mode window and its OpenGL context
-    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Shell Texturing", nullptr, nullptr);
-    if (!window) {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-    // Make the window's context current
-    glfwMakeContextCurrent(window);
-    glfwSwapInterval(1); // vsync
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback); // register callback
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, scroll_callback);
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED); // first person control
+        // Create a windowed mode window and its OpenGL context
+        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Shell Texturing", nullptr, nullptr);
+        if (!window) {
+            std::cout << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        // Make the window's context current
+        glfwMakeContextCurrent(window);
+        glfwSwapInterval(opts.benchmark ? 0 : 1); // vsync, off so benchmarks are not capped
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback); // register callback
+        glfwSetCursorPosCallback(window, mouse_callback);
+        glfwSetScrollCallback(window, scroll_callback);
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED); // first person control
 // --------------------------
-    // Initializes GLAD
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        return -1;
+        // Initializes GLAD
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::cout << "Failed to initialize GLAD" << std::endl;
+            return -1;
+        }
+        ProgramCache::init((GLADloadproc)glfwGetProcAddress, opts.shaderCacheDir);
+        ParallelShaderCompile::init((GLADloadproc)glfwGetProcAddress);
+        GeometryArena::init((GLADloadproc)glfwGetProcAddress);
     }
 
+    contextZone.end();
+
+    if (opts.glStats)
+        GLStats::install();
+
     // tell stb_image.h to flip loaded texture's on y-axis (before loading model)
     stbi_set_flip_vertically_on_load(true);
 
 // --------------------------
-    // load shaders
-    Shader cubeShader("../shaders/basic.vert", "../shaders/basic.frag");
+    // load shaders. Everything is submitted before anything is waited on, so
+    // the driver compiles in parallel; the basic.frag variants the first frame
+    // doesn't use keep compiling while it renders (see FurShaderVariants)
+    Shader overdrawShader("basic.vert", "overdraw.frag", {}, true); // fill rate diagnostics
+    Shader heatmapShader("heatmap.vert", "heatmap.frag", {}, true);
+    FurShaderVariants furShaders;
+    furShaders.build("basic.vert", "basic.frag", (LightingModel)lightingModel, flashlightOn);
+    overdrawShader.wait();
+    heatmapShader.wait();
+    ProgramCache::printSummary();
+
+    ShellUniforms overdrawShell;
+    overdrawShell.resolve(overdrawShader);
+
+    // one buffer per block, bound once and read by all fur programs
+    UniformBuffer<FrameBlock> frameBlock;
+    UniformBuffer<LightBlock> lightBlock;
+    UniformBuffer<FurBlock> furBlock;
+    frameBlock.create(FRAME_BLOCK_BINDING);
+    lightBlock.create(LIGHT_BLOCK_BINDING);
+    furBlock.create(FUR_BLOCK_BINDING);
+    bindUniformBlocks(overdrawShader);
+    UniformHandle heatCounts = heatmapShader.uniform("uCounts");
+    UniformHandle heatChannel = heatmapShader.uniform("uChannel");
+    UniformHandle heatMaxOverdraw = heatmapShader.uniform("uMaxOverdraw");
+
+    // swaps in edited shaders between frames, handles are resolved again
+    ShaderReloader shaderReloader;
+    if (opts.hotReload == 1 || (opts.hotReload < 0 && !opts.headless && !ShaderSource::directory.empty())) {
+        furShaders.watch(shaderReloader);
+        shaderReloader.watch(overdrawShader, "basic.vert", "overdraw.frag", {},
+                             [&](Shader& shader) {
+                                 overdrawShell.resolve(shader);
+                                 bindUniformBlocks(shader);
+                             });
+        shaderReloader.watch(heatmapShader, "heatmap.vert", "heatmap.frag", {},
+                             [&](Shader& shader) {
+                                 heatCounts = shader.uniform("uCounts");
+                                 heatChannel = shader.uniform("uChannel");
+                                 heatMaxOverdraw = shader.uniform("uMaxOverdraw");
+                             });
+        shaderReloader.start();
+    }
 
 // --------------------------
     // Create Sphere Object
+    ProfileScope sphereZone("generate sphere");
     float radius = 1.0f; // radius of circle to draw
     int stacks = 32;     // verticle
     int slices = 32;     // horizontal
 
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
-    // Gets the Vertices
-    for (int i = 0; i <= stacks; i++)
-    {
-        float v = float(i) / stacks;
-        float phi = v * glm::pi<float>(); // 0 --> PI
-
-        for(int j = 0; j <= slices; j++)
-        {
-            float u = float(j) / slices;
-            float theta = u * glm::two_pi<float>();
-
-            float x = sin(phi) * cos(theta);
-            float y = cos(phi);
-            float z = sin(phi) * sin(theta);
-
-            Vertex vert;
-            vert.Position = radius * glm::vec3(x, y, z);
-            vert.Normal = glm::normalize(glm::vec3(x, y, z));
-            vert.TexCoords = glm::vec2(u, v);
+    generateSphere(radius, stacks, slices, vertices, indices);
+    // every shell layer draws the sphere again, so order it for the caches
+    if (opts.optimizeMeshes)
+        MeshOptimizer::optimize(vertices, indices).report("sphere");
+    sphereZone.end();
 
-            vertices.push_back(vert);
-        }    
-    }
-    // Gets Sphere Indices
-    for(int i = 0; i < stacks; i++) {
-        for(int j = 0; j < slices; j++) {
-            int first = i * (slices + 1) + j;
-            int second = first + slices + 1;
-
-            indices.push_back(first);
-            indices.push_back(second);
-            indices.push_back(first + 1);
-
-            indices.push_back(second);
-            indices.push_back(second + 1);
-            indices.push_back(first + 1);
-        }
-    }
-    
     glm::vec3 pointLightPositions[] = {
         glm::vec3( 0.7f,  0.2f,  2.0f),
         glm::vec3( 2.3f, 3.3f, -4.0f),
@@ -328,77 +700,97 @@ int main() {
     };
 
     // Create Square Object
-    unsigned int quadVAO, quadVBO, quadEBO;
-
-    glGenVertexArrays(1, &quadVAO);
-    glGenBuffers(1, &quadVBO);
-    glGenBuffers(1, &quadEBO);
-
-    glBindVertexArray(quadVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-    glBufferData(GL_ARRAY_BUFFER, squareVertices.size() * sizeof(Vertex),
-                squareVertices.data(), GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, squareIndices.size() * sizeof(unsigned int),
-                squareIndices.data(), GL_STATIC_DRAW);
-    // Position
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(
-        0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-        (void*)offsetof(Vertex, Position)
-    );
-    // Normal
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-        (void*)offsetof(Vertex, Normal));
-    // TexCoords
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE,
-        sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-    glBindVertexArray(0);
-
-
-    // initlaize VBO and VAO
-    unsigned int VBO, VAO, EBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-    
-    // bind vertex array object 
-    glBindVertexArray(VAO);
-
-    // copy vertices into buffer (VBO) for use   
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-    
-    // set VAO -- position layout(location = 0)
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Position));
-    glEnableVertexAttribArray(0);
-    // set VAO -- color attribute layout(location = 1)
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-    glEnableVertexAttribArray(1);
-    // set VAO -- UV layout(location = 2)
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-    glEnableVertexAttribArray(2);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 indices.size() * sizeof(unsigned int),
-                 indices.data(),
-                 GL_STATIC_DRAW);
-
-    
-    // -----------------------
-    cubeShader.use();
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0); // safely unbind 
-    glBindVertexArray(0); // unbind VAO
+    ProfileScope uploadZone("upload geometry");
+    VertexBuffers quadBuffers;
+    quadBuffers.upload(squareVertices, squareIndices, STREAMS_SHELL);
+
+    // the sphere only goes through the shell programs, so it gets just the
+    // 32 byte stream they read instead of the whole Vertex, or the 16 byte one
+    VertexBuffers sphereBuffers;
+    sphereBuffers.upload(vertices, indices, opts.quantizeVertices ? STREAMS_SHELL_QUANTIZED : STREAMS_SHELL);
+    if (sphereBuffers.quantized())
+        sphereBuffers.quantization.report("sphere", vertices.size());
+    unsigned int VAO = sphereBuffers.VAO;
+    // the patches culled every frame, see Meshlets
+    Meshlets sphereMeshlets;
+    sphereMeshlets.build(vertices, indices, sphereBuffers.indexType);
+    // nothing after this reads the sphere's vertices, only the GPU copy
+    QuantizedVertexCopy sphereQuantized;
+    applyMeshResidency(opts.meshResidency, vertices, indices, sphereQuantized);
+    MeshMemory::of(vertices, indices, sphereQuantized, sphereBuffers).report("sphere", opts.meshResidency);
+    uploadZone.end();
 
     glEnable(GL_DEPTH_TEST); // enables Z-buffer test
 
+    if (opts.headless)
+        offscreen.bind(); // every frame renders into the FBO
+
+    bool fixedStep = opts.headless || opts.benchmark;
+    int frameLimit = opts.headless ? opts.frames : -1;
+    if (opts.benchmark)
+        frameLimit = opts.warmupFrames + (int)std::ceil(script.duration() / HEADLESS_DT) + 1;
+    if (opts.sweep)
+        frameLimit = opts.sweepGrid.totalFrames();
+    if (golden) {
+        frameLimit = (int)scenes.size();
+        std::filesystem::create_directories(opts.goldenDir);
+    }
+    bool recordTimings = opts.benchmark || opts.sweep; // every frame's CPU and GPU time is kept
+
+    int frameIndex = 0;
+    double headlessTotalMs = 0.0, headlessMinMs = 1e9, headlessMaxMs = 0.0;
+    std::vector<unsigned char> pixels; // readback buffer for PNG dumps
+
+    // per-pass GPU times, read back a few frames late (see GpuTimer)
+    GpuTimer gpuTimer;
+    gpuTimer.init({ "base", "shells" });
+
+    BenchmarkRecorder recorder;
+    std::vector<double> benchCpuMs, benchFrameMs;
+    std::vector<GpuFrameTiming> benchGpu(recordTimings ? frameLimit : 0);
+
+    // frame to frame pacing, over the whole run and over the last title update
+    FramePacingStats pacing, pacingWindow;
+    FrameLog frameLog;
+    if (!opts.frameLogPath.empty() && !frameLog.open(opts.frameLogPath))
+        return -1;
+    auto lastFrameStart = std::chrono::steady_clock::now();
+    double frameIntervalMs = 0.0;
+
+    // hands finished GPU frames to whoever needs every frame
+    auto drainGpuTimings = [&]() {
+        GpuFrameTiming gpu;
+        while (gpuTimer.popResolved(gpu)) {
+            if (recordTimings)
+                benchGpu[gpu.frame] = gpu;
+            frameLog.addGpu(gpu.frame, gpu.totalMs);
+        }
+    };
+
+    LayerFillStats fillStats;
+    bool layerStats = !opts.layerStatsPath.empty();
+    RenderTarget heatTarget; // per pixel fragment counts for the heatmap
+    unsigned int emptyVAO;   // the heatmap's fullscreen triangle has no vertex data
+    glGenVertexArrays(1, &emptyVAO);
+
+    startupZone.end();
+
     // Main loop
-    while (!glfwWindowShouldClose(window)) {
-        float currFrame = glfwGetTime();     // current time
+    // a windowed run with a frame limit still stops when the window is closed
+    while ((frameLimit < 0 || frameIndex < frameLimit) && (opts.headless || !glfwWindowShouldClose(window))) {
+        PROFILE_SCOPE("frame");
+        auto frameStart = std::chrono::steady_clock::now();
+        gpuTimer.beginFrame(frameIndex);
+        if (frameIndex > 0) {
+            frameIntervalMs = std::chrono::duration<double, std::milli>(frameStart - lastFrameStart).count();
+            pacing.add(frameIndex, frameIntervalMs);
+            pacingWindow.add(frameIndex, frameIntervalMs);
+        }
+        lastFrameStart = frameStart;
+
+        // headless runs step a fixed clock so every run renders the same frames
+        float currFrame = fixedStep ? (frameIndex + 1) * HEADLESS_DT
+                                    : (float)glfwGetTime(); // current time
         deltaTime = currFrame - lastFrame;   // time between frames
         lastFrame = currFrame;               // time of last frame
 
@@ -406,12 +798,26 @@ int main() {
         static int frames = 0;
         static double lastTime = 0.0;
         frames++;
-        if (glfwGetTime() - lastTime >= 1){
+        if (!fixedStep && glfwGetTime() - lastTime >= 1){
             double fps = frames / (glfwGetTime() - lastTime);
             frames = 0;
             lastTime = glfwGetTime();
 
-            std::string title = "FPS: " + std::to_string((int)fps);
+            // per-pass GPU time of the latest frame the GPU has finished
+            const GpuFrameTiming& gpu = gpuTimer.latest();
+            char passTimes[64];
+            snprintf(passTimes, sizeof(passTimes), " | GPU base %.2f ms shells %.2f ms",
+                     gpu.passMs[PASS_BASE], gpu.passMs[PASS_SHELLS]);
+            // the average hides stutter, so show the slow tail and hitches too
+            char pacingText[64];
+            snprintf(pacingText, sizeof(pacingText), " | p99 %.1f ms | hitches %lld",
+                     pacingWindow.percentile(99.0), pacing.hitchCount);
+            pacingWindow.reset();
+            std::string title = "FPS: " + std::to_string((int)fps) + pacingText + passTimes;
+            if (opts.glStats)
+                title += GLStats::titleText();
+            if (layerStats)
+                title += " | survived " + std::to_string((int)(100.0 * fillStats.lastSurvivalRate())) + "%";
             glfwSetWindowTitle(window, title.c_str());
         }
 
@@ -423,7 +829,51 @@ int main() {
         // gets correct camera to use
         Camera& activeCam = useDebugCam ? debugCam : camera;
 
-        processInput(window, activeCam, deltaTime);
+        // scripted windowed runs skip processInput, but Escape still closes them
+        if (!opts.headless && frameLimit >= 0 && glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+            glfwSetWindowShouldClose(window, true);
+
+        if (opts.benchmark) {
+            // scripted camera and fur parameters, warmup frames hold the first key
+            float scriptTime = std::max(0, frameIndex - opts.warmupFrames) * HEADLESS_DT;
+            BenchmarkKey key = script.sample(scriptTime);
+            camera.Position = key.cameraPos;
+            camera.LookAt(key.cameraTarget);
+            numLayers = key.numLayers;
+            gridFreq = key.gridFreq;
+            strandThickness = key.strandThickness;
+            furLength = key.furLength;
+        } else if (opts.sweep) {
+            // fixed default camera, only the grid cell's parameters change
+            const ParameterSweep& grid = opts.sweepGrid;
+            int cellIndex = grid.cellOf(frameIndex);
+            const SweepCell& cell = grid.cells[cellIndex];
+            if (offscreen.width != cell.width || offscreen.height != cell.height) {
+                offscreen.create(cell.width, cell.height);
+                offscreen.bind();
+            }
+            numLayers = cell.numLayers;
+            gridFreq = cell.gridFreq;
+            strandThickness = cell.strandThickness;
+            if (frameIndex % grid.framesPerCellTotal() == 0)
+                std::cout << "Sweep: cell " << cellIndex + 1 << "/" << grid.cells.size() << " "
+                          << cell.width << "x" << cell.height << " layers " << numLayers
+                          << " freq " << gridFreq << " thickness " << strandThickness << std::endl;
+        } else if (golden) {
+            // one frame per scene, at the scene's own time and without wind
+            // carried over from the previous scene's camera
+            const GoldenScene& scene = scenes[frameIndex];
+            currFrame = scene.time;
+            camera.Position = scene.cameraPos;
+            camera.LookAt(scene.cameraTarget);
+            numLayers = scene.numLayers;
+            gridFreq = scene.gridFreq;
+            strandThickness = scene.strandThickness;
+            furLength = scene.furLength;
+            furPhysics = FurPhysics();
+            furPhysics.lastCameraPos = scene.cameraPos;
+        } else if (!opts.headless)
+            processInput(window, activeCam, deltaTime);
         updateFurPhysics(activeCam, deltaTime);
 
         // Set clear color and clear 
@@ -431,10 +881,7 @@ int main() {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // use our shader program and draw first triangle
-        cubeShader.use();
-        cubeShader.setFloat("currFrame", currFrame);
-
-        cubeShader.setVec3("viewPos", activeCam.Position);
+        ProfileScope uniformZone("upload uniforms");
 
         // light properties
         glm::vec3 lightColor = glm::vec3(1.0f);
@@ -442,34 +889,38 @@ int main() {
         glm::vec3 diffuseColor = lightColor   * glm::vec3(0.4f); // decrease the influence
         glm::vec3 ambientColor = diffuseColor * glm::vec3(0.05f); // low influence
 
+        LightBlock& lights = lightBlock.data;
         // directional
-        cubeShader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f); 
-        cubeShader.setVec3("dirLight.ambient", ambientColor);
-        cubeShader.setVec3("dirLight.diffuse", diffuseColor);
-        cubeShader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
-        
-        // Point Light 1
-        cubeShader.setVec3("pointLights[0].position", pointLightPositions[0]);
-        cubeShader.setFloat("pointLights[0].constant",  1.0f);
-        cubeShader.setFloat("pointLights[0].linear",    0.09f);
-        cubeShader.setFloat("pointLights[0].quadratic", 0.032f);
-        cubeShader.setVec3("pointLights[0].ambient", ambientColor);
-        cubeShader.setVec3("pointLights[0].diffuse", diffuseColor);
-        cubeShader.setVec3("pointLights[0].specular", 1.0f, 1.0f, 1.0f);
-        
+        lights.dirLight.direction = glm::vec3(-0.2f, -1.0f, -0.3f);
+        lights.dirLight.ambient = ambientColor;
+        lights.dirLight.diffuse = diffuseColor;
+        lights.dirLight.specular = glm::vec3(0.5f, 0.5f, 0.5f);
+
+        // Point Light 1, the others stay dark but get a valid attenuation
+        // since the Phong variant adds up all NR_POINT_LIGHTS of them
+        for (int i = 0; i < NR_POINT_LIGHTS; i++) {
+            lights.pointLights[i].position = pointLightPositions[i];
+            lights.pointLights[i].constant = 1.0f;
+            lights.pointLights[i].linear = 0.09f;
+            lights.pointLights[i].quadratic = 0.032f;
+        }
+        lights.pointLights[0].ambient = ambientColor;
+        lights.pointLights[0].diffuse = diffuseColor;
+        lights.pointLights[0].specular = glm::vec3(1.0f, 1.0f, 1.0f);
+
 
         // Spot Light
-        cubeShader.setVec3("spotLight.position", camera.Position);
-        cubeShader.setVec3("spotLight.direction", camera.Front); 
-        cubeShader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
-        cubeShader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
-        cubeShader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
-        cubeShader.setFloat("spotLight.constant", 1.0f);
-        cubeShader.setFloat("spotLight.linear", 0.09f);
-        cubeShader.setFloat("spotLight.quadratic", 0.032f);
-        cubeShader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
-        cubeShader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
-        cubeShader.setInt("spotLight.FlashLightEnable", flashlightOn ? 1 : 0);
+        lights.spotLight.position = camera.Position;
+        lights.spotLight.direction = camera.Front;
+        lights.spotLight.ambient = glm::vec3(0.0f, 0.0f, 0.0f);
+        lights.spotLight.diffuse = glm::vec3(1.0f, 1.0f, 1.0f);
+        lights.spotLight.specular = glm::vec3(1.0f, 1.0f, 1.0f);
+        lights.spotLight.constant = 1.0f;
+        lights.spotLight.linear = 0.09f;
+        lights.spotLight.quadratic = 0.032f;
+        lights.spotLight.cutOff = glm::cos(glm::radians(12.5f));
+        lights.spotLight.outerCutOff = glm::cos(glm::radians(17.5f));
+        lights.spotLight.flashLightEnable = flashlightOn ? 1 : 0;
 
         glm::mat4 model = glm::mat4(1.0f);
         glm::mat4 view = glm::mat4(1.0f);
@@ -477,7 +928,8 @@ int main() {
 
         view = activeCam.GetViewMatrix();
 
-        float aspect = (float)SCR_WIDTH / (float)SCR_HEIGHT;
+        float aspect = opts.headless ? (float)offscreen.width / (float)offscreen.height
+                                    : (float)SCR_WIDTH / (float)SCR_HEIGHT;
         projection = glm::perspective(
             glm::radians(activeCam.Fov),
             aspect,
@@ -492,10 +944,6 @@ int main() {
         //     0.1f,            100.0f
         // );
 
-    
-        cubeShader.setMat4("model", model);
-        cubeShader.setMat4("view", view);
-        cubeShader.setMat4("projection", projection);
 
         glDisable(GL_CULL_FACE);
         // glDepthMask(GL_TRUE);
@@ -507,29 +955,142 @@ int main() {
         // Emulates Resting Wind
         glm::vec3 ambientWind = glm::vec3(sin(currFrame * 0.5f) * 0.3, 0.0f,
                                           cos(currFrame * 0.7f) * 0.0f);
-        glm::vec3 totalWind = furWindDirection + ambientWind;
+        glm::vec3 totalWind = furPhysics.windDirection + ambientWind;
+
+        FrameBlock& frame = frameBlock.data;
+        frame.view = view;
+        frame.projection = projection;
+        frame.viewPos = activeCam.Position;
+        frame.currFrame = currFrame;
+
+        // shell placement and strand pattern, shared with the overdraw shader
+        FurBlock& fur = furBlock.data;
+        fur.baseColor = glm::vec3(0.8f, 0.7f, 0.6f);
+        fur.numLayers = numLayers;
+        fur.furLength = furLength;
+        fur.windDirection = totalWind;
+        fur.gravity = glm::vec3(0.0f, -1.0f, 0.0f);
+        fur.strandThickness = strandThickness;
+        fur.gridFrequency = gridFreq;
+
+        // the parts of the sphere any layer of this frame can show
+        if (opts.cullMeshlets)
+            sphereMeshlets.cull(model, view, projection, Meshlets::shellReach(fur));
+        else
+            sphereMeshlets.showAll();
+
+        // one update per block, whichever programs draw this frame
+        frameBlock.upload();
+        lightBlock.upload();
+        furBlock.upload();
+
+        // the variants this frame draws with, falling back to the startup
+        // ones while the requested ones are still compiling
+        shaderReloader.update();
+        furShaders.poll();
+        FurShaderVariants::Variant& baseVariant = furShaders.base((LightingModel)lightingModel);
+        FurShaderVariants::Variant& shellVariant = furShaders.shells(flashlightOn, (LightingModel)lightingModel);
+        for (FurShaderVariants::Variant* variant : { &baseVariant, &shellVariant }) {
+            variant->shader->use();
+            variant->shader->setMat4(variant->uniforms.model, model);
+            variant->uniforms.decode.set(*variant->shader, sphereBuffers);
+        }
+        if (layerStats || overdrawMode != OVERDRAW_OFF) {
+            overdrawShader.use();
+            overdrawShader.setMat4(overdrawShell.model, model);
+            overdrawShell.decode.set(overdrawShader, sphereBuffers);
+        }
 
-        cubeShader.setVec3("baseColor", glm::vec3(0.8f, 0.7f, 0.6f));
-        cubeShader.setInt("uNumLayers", numLayers);
-        cubeShader.setFloat("uFurLength", 0.15f);
-        cubeShader.setVec3("uWindDirection", totalWind);
-        cubeShader.setVec3("uGravity", glm::vec3(0.0f, -1.0f, 0.0f));
+        uniformZone.end();
+
+        if (layerStats) {
+            // every layer on its own, once without discards and once with
+            // basic.frag, nothing is written to the color buffer
+            PROFILE_SCOPE("layer stats");
+            fillStats.beginFrame(numLayers);
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            glBindVertexArray(VAO);
+            for (int layer = 0; layer < numLayers; layer++) {
+                overdrawShader.use();
+                overdrawShader.setInt(overdrawShell.instanceOffset, layer);
+                fillStats.beginRasterized(layer);
+                sphereMeshlets.draw(sphereBuffers, 1);
+                fillStats.end();
+
+                FurShaderVariants::Variant& variant = layer == 0 ? baseVariant : shellVariant;
+                variant.shader->use();
+                variant.shader->setInt(variant.uniforms.instanceOffset, layer);
+                fillStats.beginSurvived(layer);
+                sphereMeshlets.draw(sphereBuffers, 1);
+                fillStats.end();
+            }
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            fillStats.endFrame();
+        }
 
-        cubeShader.setFloat("uStrandThickness", strandThickness);
-        cubeShader.setFloat("uGridFrequency", gridFreq);
+        if (overdrawMode != OVERDRAW_OFF) {
+            // accumulate fragment counts, then map them to colors on screen
+            PROFILE_SCOPE("overdraw heatmap");
+            GLint viewport[4];
+            glGetIntegerv(GL_VIEWPORT, viewport);
+            if (heatTarget.width != viewport[2] || heatTarget.height != viewport[3])
+                heatTarget.create(viewport[2], viewport[3], GL_RG16F, true);
+
+            // shells never write depth, so every fragment would pass anyway
+            heatTarget.bind();
+            glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            glDisable(GL_DEPTH_TEST);
+            glBlendFunc(GL_ONE, GL_ONE);
+            overdrawShader.use();
+            overdrawShader.setInt(overdrawShell.instanceOffset, 0);
+            glBindVertexArray(VAO);
+            sphereMeshlets.draw(sphereBuffers, numLayers);
+
+            glBindFramebuffer(GL_FRAMEBUFFER, opts.headless ? offscreen.FBO : 0);
+            glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+            glDisable(GL_BLEND);
+            heatmapShader.use();
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, heatTarget.colorTexture);
+            heatmapShader.setInt(heatCounts, 0);
+            heatmapShader.setInt(heatChannel, overdrawMode - 1);
+            // front and back of the sphere overlap, so up to two hits per layer
+            heatmapShader.setFloat(heatMaxOverdraw, 2.0f * numLayers);
+            glBindVertexArray(emptyVAO);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glEnable(GL_DEPTH_TEST);
+        } else {
+            // Draws the circle, base layer and shells are separate draws so
+            // they can be timed separately (uInstanceOffset keeps layer ids)
+            PROFILE_SCOPE("draw");
+            glBindVertexArray(VAO);
+            gpuTimer.beginPass(PASS_BASE);
+            baseVariant.shader->use();
+            baseVariant.shader->setInt(baseVariant.uniforms.instanceOffset, 0);
+            // the opaque base writes depth so it hides the far side's shells,
+            // which is what lets Meshlets skip them without a visible change
+            glDepthMask(GL_TRUE);
+            sphereMeshlets.draw(sphereBuffers, 1);
+            glDepthMask(GL_FALSE);
+            gpuTimer.endPass(PASS_BASE);
+
+            if (numLayers > 1) {
+                gpuTimer.beginPass(PASS_SHELLS);
+                shellVariant.shader->use();
+                shellVariant.shader->setInt(shellVariant.uniforms.instanceOffset, 1);
+                sphereMeshlets.draw(sphereBuffers, numLayers - 1);
+                gpuTimer.endPass(PASS_SHELLS);
+            }
+        }
 
-        // Draws the circle
-        glBindVertexArray(VAO);
-        glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)indices.size(),
-                                GL_UNSIGNED_INT, 0, numLayers);
-        
         glDepthMask(GL_TRUE);
         glDisable(GL_BLEND);
         // cubeShader.setMat4("model", model);
         // Draws Flat Square
         // model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
         // 
-        // glBindVertexArray(quadVAO);
+        // glBindVertexArray(quadBuffers.VAO);
         // glDrawElementsInstanced(
         //     GL_TRIANGLES,
         //     (GLsizei)squareIndices.size(),
@@ -539,20 +1100,173 @@ int main() {
         // );
         glBindVertexArray(0);
 
-        // Swap front and back buffers
-        glfwSwapBuffers(window);
-        // Poll for and process events
-        glfwPollEvents();
+        double cpuMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - frameStart).count();
+        gpuTimer.endFrame();
+
+        if (opts.headless) {
+            // nothing is presented, so wait for the GPU to get honest frame times
+            {
+                PROFILE_SCOPE("glFinish");
+                glFinish();
+            }
+
+            if (!opts.dumpDir.empty() && frameIndex % opts.dumpEvery == 0) {
+                PROFILE_SCOPE("dump frame");
+                offscreen.readPixels(pixels);
+                char name[32];
+                snprintf(name, sizeof(name), "/frame_%05d.png", frameIndex);
+                writePNG(opts.dumpDir + name, offscreen.width, offscreen.height, pixels.data());
+            }
+
+            if (golden) {
+                PROFILE_SCOPE("golden compare");
+                const GoldenScene& scene = scenes[frameIndex];
+                std::string base = opts.goldenDir + "/" + scene.name;
+                offscreen.readPixels(pixels);
+                if (opts.goldenUpdate) {
+                    writePNG(base + ".png", offscreen.width, offscreen.height, pixels.data());
+                    std::cout << "Golden: updated " << base << ".png" << std::endl;
+                } else {
+                    std::vector<unsigned char> reference, diff;
+                    ImageDiff result;
+                    result.sizeMismatch = true;
+                    result.failedPct = 100.0;
+                    if (GoldenCompare::load(base + ".png", offscreen.width, offscreen.height, reference))
+                        result = opts.goldenCompare.compare(pixels, reference, offscreen.width,
+                                                            offscreen.height, diff);
+                    bool pass = opts.goldenCompare.passed(result);
+                    if (!pass) {
+                        goldenFailures++;
+                        writePNG(base + "_actual.png", offscreen.width, offscreen.height, pixels.data());
+                        if (!diff.empty())
+                            writePNG(base + "_diff.png", offscreen.width, offscreen.height, diff.data());
+                    }
+                    char line[160];
+                    snprintf(line, sizeof(line), "Golden %-12s %s  differing %.3f%%  mean dE %.3f  max dE %.1f  PSNR %.1f dB",
+                             scene.name.c_str(), pass ? "PASS" : "FAIL", result.failedPct,
+                             result.meanDeltaE, result.maxDeltaE, result.psnr);
+                    std::cout << line << std::endl;
+                }
+            }
+        } else {
+            PROFILE_SCOPE("present");
+            // Swap front and back buffers
+            glfwSwapBuffers(window);
+            // Poll for and process events
+            glfwPollEvents();
+        }
+
+        if (opts.glStats)
+            GLStats::endFrame();
+
+        double frameMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - frameStart).count();
+        headlessTotalMs += frameMs;
+        headlessMinMs = std::min(headlessMinMs, frameMs);
+        headlessMaxMs = std::max(headlessMaxMs, frameMs);
+        if (recordTimings) {
+            benchCpuMs.push_back(cpuMs);
+            benchFrameMs.push_back(frameMs);
+        }
+        frameLog.addFrame(frameIndex, frameIntervalMs, cpuMs, numLayers);
+        drainGpuTimings();
+        frameIndex++;
     }
 
+    // the run is over, so waiting on the last few frames is fine
+    gpuTimer.collect(true);
+    drainGpuTimings();
+    frameLog.close();
+    pacing.printSummary("Frame pacing");
+    if (opts.glStats) {
+        GLStats::printSummary();
+        long long uploads = UniformUploadStats::issued + UniformUploadStats::elided;
+        if (uploads > 0)
+            std::cout << "Uniform shadow: " << UniformUploadStats::issued << " uploads issued, "
+                      << UniformUploadStats::elided << " elided ("
+                      << 100.0 * UniformUploadStats::elided / uploads << "%)" << std::endl;
+    }
+
+    if (opts.benchmark) {
+        if (gpuTimer.droppedFrames > 0)
+            std::cout << "Benchmark: " << gpuTimer.droppedFrames << " frames without GPU timings" << std::endl;
+
+        // warmup frames are dropped
+        recorder.passNames = gpuTimer.passNames;
+        for (int i = opts.warmupFrames; i < frameIndex; i++) {
+            recorder.addFrame(benchCpuMs[i], benchFrameMs[i]);
+            if (benchGpu[i].frame >= 0) // dropped queries leave the default entry
+                recorder.addGpuFrame(benchGpu[i].totalMs, benchGpu[i].passMs);
+        }
+
+        FrameTimeStats frameStats = FrameTimeStats::compute(recorder.frameMs);
+        std::cout << "Benchmark '" << script.name << "': " << recorder.frameMs.size() << " frames"
+                  << " p50 " << frameStats.p50 << " ms"
+                  << " p95 " << frameStats.p95 << " ms"
+                  << " p99 " << frameStats.p99 << " ms"
+                  << " max " << frameStats.max << " ms" << std::endl;
+        recorder.writeJSON(opts.jsonPath, script.name, (const char*)glGetString(GL_RENDERER),
+                           opts.headless ? opts.width : SCR_WIDTH,
+                           opts.headless ? opts.height : SCR_HEIGHT, opts.warmupFrames);
+    }
+
+    if (opts.sweep) {
+        if (gpuTimer.droppedFrames > 0)
+            std::cout << "Sweep: " << gpuTimer.droppedFrames << " frames without GPU timings" << std::endl;
+
+        ParameterSweep& grid = opts.sweepGrid;
+        for (BenchmarkRecorder& cellResult : grid.results)
+            cellResult.passNames = gpuTimer.passNames;
+        for (int i = 0; i < frameIndex; i++) {
+            grid.addFrame(i, benchCpuMs[i], benchFrameMs[i]);
+            if (benchGpu[i].frame >= 0)
+                grid.addGpuFrame(i, benchGpu[i].totalMs, benchGpu[i].passMs);
+        }
+        if (grid.writeCSV(opts.csvPath))
+            std::cout << "Sweep: results written to " << opts.csvPath << std::endl;
+    }
+
+    if (opts.headless && !opts.sweep && frameIndex > 0) {
+        std::cout << "Rendered " << frameIndex << " frames at "
+                  << opts.width << "x" << opts.height
+                  << " avg " << headlessTotalMs / frameIndex << " ms"
+                  << " min " << headlessMinMs << " ms"
+                  << " max " << headlessMaxMs << " ms" << std::endl;
+    }
+
+    if (!opts.tracePath.empty())
+        Profiler::writeChromeTrace(opts.tracePath);
+
+    if (layerStats) {
+        fillStats.flush();
+        fillStats.printSummary();
+        fillStats.writeCSV(opts.layerStatsPath);
+    }
+    if (opts.headless)
+        sphereMeshlets.printSummary("sphere");
+
     // de-allocate all resources once they've outlived their purpose:
     // ------------------------------------------------------------------------
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
+    sphereBuffers.destroy();
+    sphereMeshlets.destroy();
+    quadBuffers.destroy();
+    glDeleteVertexArrays(1, &emptyVAO);
+    frameBlock.destroy();
+    lightBlock.destroy();
+    furBlock.destroy();
+    shaderReloader.stop();
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
-    glfwTerminate();
+    if (!opts.headless)
+        glfwTerminate();
+
+    if (golden && !opts.goldenUpdate) {
+        std::cout << "Golden: " << scenes.size() - goldenFailures << "/" << scenes.size()
+                  << " scenes match" << std::endl;
+        if (goldenFailures > 0)
+            return 1;
+    }
     return 0;
 }
\ No newline at end of file
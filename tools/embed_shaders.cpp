@@ -0,0 +1,89 @@
+#include "ShaderPreprocessor.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+/* ----------
+Build step that compiles shaders/ into the executable (see the CMakeLists):
+- embed_shaders OUT.h SHADER_DIR FILE...
+Every FILE gets its #includes expanded by ShaderPreprocessor and ends up in
+OUT.h as an EmbeddedShader, named relative to SHADER_DIR.
+---------- */
+
+// source text as a C string literal, one literal per line
+static void writeLiteral(std::ostream& out, const std::string& text)
+{
+    out << "        \"";
+    for (size_t i = 0; i < text.size(); i++) {
+        unsigned char c = (unsigned char)text[i];
+        if (c == '\n') {
+            out << "\\n\"";
+            if (i + 1 < text.size())
+                out << "\n        \"";
+            continue;
+        }
+        if (c == '\\' || c == '"')
+            out << '\\' << c;
+        else if (c == '\t')
+            out << "\\t";
+        else if (c < 0x20 || c >= 0x7F) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\%03o", c); // octal, stops after 3 digits
+            out << escaped;
+        }
+        else
+            out << c;
+    }
+    if (text.empty() || text.back() != '\n')
+        out << "\"";
+}
+
+static std::string relativeName(const std::string& path, const std::filesystem::path& directory)
+{
+    std::error_code error;
+    std::filesystem::path relative = std::filesystem::relative(path, directory, error);
+    return error ? path : relative.generic_string();
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        std::cout << "usage: embed_shaders OUT.h SHADER_DIR FILE..." << std::endl;
+        return 1;
+    }
+    std::string outPath = argv[1];
+    std::filesystem::path directory = argv[2];
+
+    std::ostringstream out;
+    out << "// Generated by tools/embed_shaders.cpp from the shaders directory, do not edit\n";
+    out << "#ifndef EMBEDDED_SHADERS_H\n#define EMBEDDED_SHADERS_H\n\n";
+    out << "inline const EmbeddedShader embeddedShaders[] = {\n";
+    for (int i = 3; i < argc; i++) {
+        ShaderPreprocessor preprocessor;
+        std::string code;
+        if (!preprocessor.process(argv[i], code))
+            return 1;
+        std::string files;
+        for (const std::string& file : preprocessor.files)
+            files += relativeName(file, directory) + "\n";
+
+        out << "    { \"" << relativeName(argv[i], directory) << "\",\n";
+        writeLiteral(out, code);
+        out << ",\n        " << code.size() << ",\n";
+        writeLiteral(out, files);
+        out << " },\n";
+    }
+    out << "};\n\n#endif\n";
+
+    std::ofstream file(outPath, std::ios::binary);
+    file << out.str();
+    if (!file) {
+        std::cout << "ERROR::EMBED_SHADERS::COULD_NOT_WRITE " << outPath << std::endl;
+        return 1;
+    }
+    return 0;
+}